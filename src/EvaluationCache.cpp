@@ -0,0 +1,123 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "EvaluationCache.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cassert>
+
+//== IMPLEMENTATION ============================================================
+
+EvaluationCache::
+EvaluationCache(const MultilinearModel& mlm)
+    : mlm_(mlm), tolerance_(0.0)
+{
+    reset_counters();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+EvaluationCache::
+reset_counters()
+{
+    counters_.contraction_hits = counters_.contraction_misses = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+EvaluationCache::
+invalidate()
+{
+    contracted_w_skull_.resize(0);
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+EvaluationCache::
+changed(const Eigen::VectorXd& w, const Eigen::VectorXd& cached) const
+{
+    if (w.size() != cached.size())
+        return true;
+    return (w - cached).norm() > tolerance_ * cached.norm();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+EvaluationCache::
+update_contraction(const Eigen::VectorXd& w_skull)
+{
+    if (changed(w_skull, contracted_w_skull_))
+    {
+        mlm_.contract_skull(contracted_, w_skull);
+        contracted_w_skull_ = w_skull;
+        ++counters_.contraction_misses;
+        Profiler::instance().add_count("cache/contraction_miss");
+    }
+    else
+    {
+        ++counters_.contraction_hits;
+        Profiler::instance().add_count("cache/contraction_hit");
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+const Eigen::VectorXd&
+EvaluationCache::
+evaluate(const Eigen::VectorXd& w_skull, const Eigen::VectorXd& w_fstt)
+{
+    // the FSTT parameters only need the cheap second contraction
+    update_contraction(w_skull);
+    mlm_.evaluate_contracted(points_, contracted_, w_fstt);
+    return points_;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+EvaluationCache::
+jacobian(Eigen::MatrixXd& jacobian, const std::vector<unsigned int>& vertices,
+         const Eigen::VectorXd& w_skull, const Eigen::VectorXd& w_fstt)
+{
+    ScopedTimer timer("evaluate/jacobian_cached");
+
+    assert(w_skull.size() == mlm_.dim1());
+    assert(w_fstt.size()  == mlm_.dim2());
+
+    const unsigned int dim1 = mlm_.dim1(), dim2 = mlm_.dim2();
+    update_contraction(w_skull);
+
+    // d/dwFstt(k) = sum_j T(i,j,k) wSkull(j) is the skull contraction,
+    // d/dwSkull(j) = sum_k T(i,j,k) wFstt(k) is computed for the given rows
+    jacobian.resize(3*vertices.size(), dim1 + dim2);
+#pragma omp parallel for
+    for (int r=0; r<(int)(3*vertices.size()); ++r)
+    {
+        const unsigned int i = 3*vertices[r/3] + r%3;
+        assert(i < mlm_.dim0());
+
+        jacobian.block(r, dim1, 1, dim2) = contracted_.row(i);
+        for (unsigned int j=0; j<dim1; ++j)
+        {
+            double c(0.0);
+            for (unsigned int k=0; k<dim2; ++k)
+                c += mlm_.tensor_entry(i,j,k) * w_fstt(k);
+            jacobian(r, j) = c;
+        }
+    }
+}
+
+//=============================================================================
@@ -0,0 +1,99 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+//== INCLUDES =================================================================
+
+#include <vector>
+#include <Eigen/Dense>
+
+#include "MultilinearModel.h"
+
+
+//== CLASS DEFINITION =========================================================
+
+//! Caching evaluation layer for iterative fitting, where consecutive calls
+//! use nearly the same parameters. The skull contraction of the tensor, the
+//! expensive part of an evaluation, is kept and reused as long as the skull
+//! parameters change by less than a relative tolerance (by default only for
+//! identical parameters, which keeps results exact). Evaluations then only
+//! apply the FSTT parameters to it, and it provides the FSTT columns of the
+//! Jacobian for free.
+class EvaluationCache
+{
+public:
+
+    //! hit and miss counters
+    struct Counters
+    {
+        unsigned long contraction_hits, contraction_misses;
+    };
+
+    //! constructor
+    EvaluationCache(const MultilinearModel& mlm);
+
+    //! set relative skull parameter change below which the contraction is reused
+    void set_tolerance(double tolerance) { tolerance_ = tolerance; }
+
+    //! relative skull parameter change below which the contraction is reused
+    double tolerance() const { return tolerance_; }
+
+    //! evaluate the model (see MultilinearModel::evaluate())
+    const Eigen::VectorXd& evaluate(const Eigen::VectorXd& w_skull, const Eigen::VectorXd& w_fstt);
+
+    //! skull parameters of the cached contraction, i.e., the last evaluation
+    //! is exact for these instead of the requested ones. since the model is
+    //! linear in the skull parameters, the difference is corrected by the
+    //! skull columns of the Jacobian.
+    const Eigen::VectorXd& contraction_parameters() const { return contracted_w_skull_; }
+
+    //! compute the Jacobian of the given vertices (see MultilinearModel::jacobian())
+    void jacobian(Eigen::MatrixXd& jacobian, const std::vector<unsigned int>& vertices,
+                  const Eigen::VectorXd& w_skull, const Eigen::VectorXd& w_fstt);
+
+    //! drop all cached results
+    void invalidate();
+
+    //! hit and miss counters
+    const Counters& counters() const { return counters_; }
+
+    //! reset hit and miss counters
+    void reset_counters();
+
+private:
+
+    //! has 'w' changed w.r.t. the cached 'cached' by more than the tolerance?
+    bool changed(const Eigen::VectorXd& w, const Eigen::VectorXd& cached) const;
+
+    //! make sure the skull contraction is valid for 'w_skull'
+    void update_contraction(const Eigen::VectorXd& w_skull);
+
+private:
+
+    //! the multilinear model
+    const MultilinearModel& mlm_;
+    //! relative tolerance
+    double tolerance_;
+
+    //! tensor contracted with contracted_w_skull_
+    Eigen::MatrixXd contracted_;
+    Eigen::VectorXd contracted_w_skull_;
+
+    //! last evaluation
+    Eigen::VectorXd points_;
+
+    //! hit and miss counters
+    Counters counters_;
+};
+
+//=============================================================================
@@ -0,0 +1,159 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "FitIndex.h"
+#include "Profiler.h"
+#include "utils.h"
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+//== IMPLEMENTATION ============================================================
+
+FitIndex::
+FitIndex(const MultilinearModel& mlm)
+    : mlm_(mlm), n_indexed_(0)
+{
+    // the columns of U_skull and U_fstt are orthonormal, hence all parameters
+    // vary alike over the training set; the eigenvalues tell how much shape
+    // variation a unit change of each parameter causes
+    scale_.resize(mlm_.dim1() + mlm_.dim2());
+    scale_.head(mlm_.dim1()) = mlm_.eigenvalues_skull().cwiseMax(0.0).cwiseSqrt();
+    scale_.tail(mlm_.dim2()) = mlm_.eigenvalues_fstt().cwiseMax(0.0).cwiseSqrt();
+    parameters_.resize(scale_.size(), 0);
+}
+
+//-----------------------------------------------------------------------------
+
+unsigned int
+FitIndex::
+add(const Eigen::VectorXd& w_skull, const Eigen::VectorXd& w_fstt,
+    const std::string& name)
+{
+    assert(w_skull.size() == mlm_.dim1());
+    assert(w_fstt.size()  == mlm_.dim2());
+
+    const unsigned int i = parameters_.cols();
+    parameters_.conservativeResize(Eigen::NoChange, i + 1);
+    parameters_.col(i) << w_skull, w_fstt;
+    names_.push_back(name.empty() ? std::to_string(i) : name);
+
+    return i;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+FitIndex::
+add(const std::string& dirname)
+{
+    Eigen::VectorXd w_skull(mlm_.dim1()), w_fstt(mlm_.dim2());
+    if (!load_parameters(w_skull, w_fstt,
+                         dirname + "/w_skull.scalars",
+                         dirname + "/w_fstt.scalars"))
+        return false;
+
+    add(w_skull, w_fstt, dirname);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+FitIndex::
+build()
+{
+    ScopedTimer timer("index/build");
+
+    tree_.build(scale_.asDiagonal() * parameters_);
+    n_indexed_ = parameters_.cols();
+}
+
+//-----------------------------------------------------------------------------
+
+Eigen::VectorXd
+FitIndex::
+weighted(const Eigen::VectorXd& w_skull, const Eigen::VectorXd& w_fstt) const
+{
+    assert(w_skull.size() == mlm_.dim1());
+    assert(w_fstt.size()  == mlm_.dim2());
+
+    Eigen::VectorXd w(scale_.size());
+    w << w_skull, w_fstt;
+    return scale_.cwiseProduct(w);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+FitIndex::
+query(const Eigen::VectorXd& w_skull, const Eigen::VectorXd& w_fstt,
+      unsigned int k, std::vector<Neighbor>& neighbors) const
+{
+    ScopedTimer timer("index/query");
+
+    if (n_indexed_ != parameters_.cols())
+        std::cerr << "[WARNING] in 'FitIndex::query(...)' - Index is outdated, call build()" << std::endl;
+
+    std::vector<KdTree::Neighbor> nn;
+    tree_.knn(weighted(w_skull, w_fstt), k, nn);
+
+    neighbors.resize(nn.size());
+    for (unsigned int i=0; i<nn.size(); ++i)
+    {
+        neighbors[i].index           = nn[i].second;
+        neighbors[i].distance        = std::sqrt(nn[i].first);
+        neighbors[i].vertex_distance = -1.0;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void
+FitIndex::
+query_reranked(const Eigen::VectorXd& w_skull, const Eigen::VectorXd& w_fstt,
+               unsigned int k, unsigned int n_candidates,
+               std::vector<Neighbor>& neighbors) const
+{
+    query(w_skull, w_fstt, std::max(k, n_candidates), neighbors);
+    if (neighbors.empty())
+        return;
+
+    ScopedTimer timer("index/rerank");
+
+    // evaluate query and candidates in a single pass over the tensor
+    const unsigned int n = neighbors.size();
+    Eigen::MatrixXd ws(mlm_.dim1(), n+1), wf(mlm_.dim2(), n+1);
+    ws.col(0) = w_skull;
+    wf.col(0) = w_fstt;
+    for (unsigned int i=0; i<n; ++i)
+    {
+        ws.col(i+1) = parameters_.col(neighbors[i].index).head(mlm_.dim1());
+        wf.col(i+1) = parameters_.col(neighbors[i].index).tail(mlm_.dim2());
+    }
+
+    Eigen::MatrixXd points;
+    mlm_.evaluate_batch(points, ws, wf);
+
+    const double n_vertices = mlm_.dim0() / 3;
+    for (unsigned int i=0; i<n; ++i)
+        neighbors[i].vertex_distance = std::sqrt((points.col(i+1) - points.col(0)).squaredNorm() / n_vertices);
+
+    std::sort(neighbors.begin(), neighbors.end(),
+              [](const Neighbor& a, const Neighbor& b)
+              { return a.vertex_distance < b.vertex_distance; });
+    if (neighbors.size() > k)
+        neighbors.resize(k);
+}
+
+//=============================================================================
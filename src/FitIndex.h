@@ -0,0 +1,104 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+//== INCLUDES =================================================================
+
+#include <vector>
+#include <string>
+#include <Eigen/Dense>
+
+#include "MultilinearModel.h"
+#include "KdTree.h"
+
+
+//== CLASS DEFINITION =========================================================
+
+//! Index of fitted parameter vectors (w_skull, w_fstt) for finding the most
+//! similar heads. Parameters are compared in a weighted Euclidean metric,
+//! where each mode is weighted by its eigenvalue (the shape variance it
+//! explains), such that parameter distances approximate vertex distances.
+//! Candidates can optionally be re-ranked by the RMS vertex distance of
+//! the evaluated meshes.
+class FitIndex
+{
+public:
+
+    //! a query result
+    struct Neighbor
+    {
+        unsigned int index;      //!< index of the fit
+        double distance;         //!< weighted parameter distance
+        double vertex_distance;  //!< RMS vertex distance, if re-ranked (else -1)
+    };
+
+    //! constructor, takes the mode weights from the model's eigenvalues
+    FitIndex(const MultilinearModel& mlm);
+
+    //! add a fit with an optional name, returns its index
+    unsigned int add(const Eigen::VectorXd& w_skull, const Eigen::VectorXd& w_fstt,
+                     const std::string& name = "");
+
+    //! add a fit stored as w_skull.scalars and w_fstt.scalars in 'dirname'
+    bool add(const std::string& dirname);
+
+    //! (re-)build the search structure after adding fits
+    void build();
+
+    //! the k fits closest to (w_skull, w_fstt) in the weighted parameter metric
+    void query(const Eigen::VectorXd& w_skull, const Eigen::VectorXd& w_fstt,
+               unsigned int k, std::vector<Neighbor>& neighbors) const;
+
+    //! the k fits closest to (w_skull, w_fstt) in vertex space, re-ranked
+    //! from the 'n_candidates' closest fits in parameter space
+    void query_reranked(const Eigen::VectorXd& w_skull, const Eigen::VectorXd& w_fstt,
+                        unsigned int k, unsigned int n_candidates,
+                        std::vector<Neighbor>& neighbors) const;
+
+    //! number of fits
+    unsigned int size() const { return names_.size(); }
+
+    //! name of fit i
+    const std::string& name(unsigned int i) const { return names_[i]; }
+
+    //! skull parameters of fit i
+    Eigen::VectorXd w_skull(unsigned int i) const { return parameters_.col(i).head(mlm_.dim1()); }
+
+    //! FSTT parameters of fit i
+    Eigen::VectorXd w_fstt(unsigned int i) const { return parameters_.col(i).tail(mlm_.dim2()); }
+
+private:
+
+    //! map parameters into the weighted space
+    Eigen::VectorXd weighted(const Eigen::VectorXd& w_skull, const Eigen::VectorXd& w_fstt) const;
+
+private:
+
+    //! the multilinear model
+    const MultilinearModel& mlm_;
+
+    //! square roots of the mode weights
+    Eigen::VectorXd scale_;
+
+    //! parameters of all fits, one column per fit (w_skull, then w_fstt)
+    Eigen::MatrixXd parameters_;
+    //! names of all fits
+    std::vector<std::string> names_;
+
+    //! k-d tree over the weighted parameters
+    KdTree tree_;
+    //! number of fits in tree_
+    unsigned int n_indexed_;
+};
+
+//=============================================================================
@@ -0,0 +1,174 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "KdTree.h"
+#include <algorithm>
+#include <cfloat>
+#include <cassert>
+
+//== HELPER ===================================================================
+
+namespace {
+
+//! maximum number of points per leaf
+const unsigned int max_leaf_size = 8;
+
+} // anonymous namespace
+
+
+//== IMPLEMENTATION ============================================================
+
+KdTree::
+KdTree()
+{
+}
+
+//-----------------------------------------------------------------------------
+
+void
+KdTree::
+build(const Eigen::MatrixXd& points)
+{
+    const unsigned int n = points.cols();
+
+    order_.resize(n);
+    for (unsigned int i=0; i<n; ++i)
+        order_[i] = i;
+
+    points_ = points;
+    nodes_.clear();
+    nodes_.reserve(2*n / max_leaf_size + 1);
+    if (n) build_node(0, n);
+
+    // store points in leaf order for cache-friendly scans
+    for (unsigned int i=0; i<n; ++i)
+        points_.col(i) = points.col(order_[i]);
+}
+
+//-----------------------------------------------------------------------------
+
+int
+KdTree::
+build_node(unsigned int first, unsigned int count)
+{
+    const int index = nodes_.size();
+    nodes_.push_back(Node());
+    nodes_[index].right = -1;
+    nodes_[index].axis  = 0;
+    nodes_[index].split = 0.0;
+    nodes_[index].first = first;
+    nodes_[index].count = count;
+
+    if (count <= max_leaf_size)
+        return index;
+
+    // split at the median along the axis of largest extent
+    Eigen::VectorXd lo = points_.col(order_[first]), hi = lo;
+    for (unsigned int i=first+1; i<first+count; ++i)
+    {
+        lo = lo.cwiseMin(points_.col(order_[i]));
+        hi = hi.cwiseMax(points_.col(order_[i]));
+    }
+    int axis;
+    (hi - lo).maxCoeff(&axis);
+
+    const unsigned int half = count / 2;
+    const Eigen::MatrixXd& P = points_;
+    std::nth_element(order_.begin() + first, order_.begin() + first + half,
+                     order_.begin() + first + count,
+                     [&P, axis](unsigned int a, unsigned int b)
+                     { return P(axis, a) < P(axis, b); });
+
+    nodes_[index].axis  = axis;
+    nodes_[index].split = points_(axis, order_[first + half]);
+
+    build_node(first, half);
+    const int right = build_node(first + half, count - half);
+    nodes_[index].right = right;
+
+    return index;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+KdTree::
+knn(const Eigen::VectorXd& query, unsigned int k,
+    std::vector<Neighbor>& neighbors) const
+{
+    assert(query.size() == points_.rows());
+
+    neighbors.clear();
+    k = std::min(k, size());
+    if (!k) return;
+
+    // max-heap of the k best candidates
+    neighbors.reserve(k);
+    search(0, query, k, neighbors);
+    std::sort_heap(neighbors.begin(), neighbors.end());
+
+    for (auto& n : neighbors)
+        n.second = order_[n.second];
+}
+
+//-----------------------------------------------------------------------------
+
+KdTree::Neighbor
+KdTree::
+nearest(const Eigen::VectorXd& query) const
+{
+    std::vector<Neighbor> neighbors;
+    knn(query, 1, neighbors);
+    return neighbors.empty() ? Neighbor(DBL_MAX, 0) : neighbors[0];
+}
+
+//-----------------------------------------------------------------------------
+
+void
+KdTree::
+search(int index, const Eigen::VectorXd& query, unsigned int k,
+       std::vector<Neighbor>& heap) const
+{
+    const Node& node = nodes_[index];
+
+    if (node.right < 0)
+    {
+        for (unsigned int i=node.first; i<node.first+node.count; ++i)
+        {
+            const double d = (points_.col(i) - query).squaredNorm();
+            if (heap.size() < k)
+            {
+                heap.push_back(Neighbor(d, i));
+                std::push_heap(heap.begin(), heap.end());
+            }
+            else if (d < heap.front().first)
+            {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.back() = Neighbor(d, i);
+                std::push_heap(heap.begin(), heap.end());
+            }
+        }
+        return;
+    }
+
+    // descend into the query's side first, visit the other side only if
+    // the splitting plane is closer than the current k-th neighbor
+    const double diff = query(node.axis) - node.split;
+    const int near = (diff < 0.0) ? index + 1 : node.right;
+    const int far  = (diff < 0.0) ? node.right : index + 1;
+
+    search(near, query, k, heap);
+    if (heap.size() < k || diff*diff < heap.front().first)
+        search(far, query, k, heap);
+}
+
+//=============================================================================
@@ -0,0 +1,81 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+//== INCLUDES =================================================================
+
+#include <vector>
+#include <utility>
+#include <Eigen/Dense>
+
+
+//== CLASS DEFINITION =========================================================
+
+//! k-d tree for exact nearest-neighbor queries among points of arbitrary
+//! (moderate) dimension, e.g. 3D target points or model parameter vectors.
+//! Queries are const and can be run concurrently.
+class KdTree
+{
+public:
+
+    //! a query result: squared Euclidean distance and point index
+    typedef std::pair<double, unsigned int> Neighbor;
+
+    //! constructor
+    KdTree();
+
+    //! build tree over the columns of 'points' (dimension x #points)
+    void build(const Eigen::MatrixXd& points);
+
+    //! the k nearest points to 'query', sorted by increasing distance
+    void knn(const Eigen::VectorXd& query, unsigned int k,
+             std::vector<Neighbor>& neighbors) const;
+
+    //! nearest point to 'query' (squared distance and index)
+    Neighbor nearest(const Eigen::VectorXd& query) const;
+
+    //! number of points
+    unsigned int size() const { return points_.cols(); }
+
+    //! dimension of points
+    unsigned int dimension() const { return points_.rows(); }
+
+private:
+
+    //! tree node, children of inner node i are i+1 and 'right'
+    struct Node
+    {
+        int right;                 //!< right child, -1 for leaves
+        int axis;                  //!< split axis
+        double split;              //!< split value
+        unsigned int first, count; //!< range in order_ for leaves
+    };
+
+    //! recursively build node for order_[first, first+count)
+    int build_node(unsigned int first, unsigned int count);
+
+    //! search subtree 'node' for the k nearest neighbors of 'query'
+    void search(int node, const Eigen::VectorXd& query, unsigned int k,
+                std::vector<Neighbor>& heap) const;
+
+private:
+
+    //! points, reordered such that leaves reference contiguous columns
+    Eigen::MatrixXd points_;
+    //! original index of each column of points_
+    std::vector<unsigned int> order_;
+    //! tree nodes, root is node 0
+    std::vector<Node> nodes_;
+};
+
+//=============================================================================
@@ -12,9 +12,12 @@
 
 #include "MLMViewer.h"
 #include "utils.h"
+#include "Profiler.h"
+#include "PointCloudIO.h"
 
 #include <imgui.h>
 
+#include <algorithm>
 #include <cfloat>
 #include <iostream>
 #include <sstream>
@@ -42,6 +45,15 @@ MLMViewer::MLMViewer(const char* title, int width, int height, bool showgui)
     alpha_       = 1.0;
 
     conter_save_meshes_ = 1;
+    export_format_      = 0; // ASCII OFF
+
+    // vertex dragging
+    edit_mode_           = false;
+    edit_parameters_     = 0;
+    edit_regularization_ = 0.1f;
+    dragging_            = false;
+    drag_vertex_         = 0;
+    drag_depth_          = 0.0f;
 
     // set colors and material
     skin_.set_front_color(vec3(1.0, 0.85, 0.8));
@@ -78,6 +90,13 @@ bool MLMViewer::load_mlm(const char* dir)
     }
 
 
+    // skin and skull topology for saving meshes
+    if (!exporter_.set_topology(skin_, skull_))
+    {
+        return false;
+    }
+
+
     // update scene center and bounds
     BoundingBox bb = skin_.bounds();
     set_scene(bb.center(), 0.5 * bb.size());
@@ -95,28 +114,24 @@ bool MLMViewer::load_mlm(const char* dir)
         << skull_.n_faces() << " faces\n";
 
 
-    // load means
-    if (!mlm_.load_means(filenameSkin, filenameSkull))
-    {
-        std::cerr << "Cannot load means\n";
-        return false;
-    }
-
-
-    // load mlm tensor, matrix U_skull, matrix U_fstt, eigenvalues_skull, eigenvalues_fstt
-    // and compute multilinear model tensor
+    // load means, mlm tensor, matrix U_skull, matrix U_fstt, eigenvalues_skull,
+    // and eigenvalues_fstt through the registry, which shares the mean
+    // meshes with further models of the same topology
     std::cout << "Loading multilinear model (this may take a while) ..." << std::flush;
-    if (!mlm_.load(dir))
+    registry_.add(dir, dir);
+    mlm_ = registry_.get(dir);
+    if (!mlm_)
     {
         std::cerr << "Cannot load multilinear model\n";
         return false;
     }
+    model_name_ = dir;
     std::cout << "done." << std::endl << std::flush;
 
 
     // initialize parameters and evaluate model
     init_parameters(true, true);
-    mlm_.evaluate(skin_, skull_, w_skull_,  w_fstt_);
+    evaluate_mlm();
     update_meshes();
 
 
@@ -133,18 +148,91 @@ bool MLMViewer::load_mlm(const char* dir)
 
 //-----------------------------------------------------------------------------
 
+void MLMViewer::add_mlm(const char* dir)
+{
+    registry_.add(dir, dir);
+}
+
+//-----------------------------------------------------------------------------
+
+bool MLMViewer::switch_mlm(const std::string& name)
+{
+    if (name == model_name_)
+        return true;
+
+    std::shared_ptr<const MultilinearModel> mlm = registry_.get(name);
+    if (!mlm)
+    {
+        return false;
+    }
+
+    // keep the current meshes, which requires the same topology
+    if (mlm->n_skin_vertices()  != skin_.n_vertices() ||
+        mlm->n_skull_vertices() != skull_.n_vertices())
+    {
+        std::cerr << "Cannot switch to model " << name << ": different topology\n";
+        return false;
+    }
+
+    // keep the parameters if their dimensions match
+    const bool same_dimensions = (mlm->dim1() == mlm_->dim1() &&
+                                  mlm->dim2() == mlm_->dim2());
+
+    mlm_ = mlm;
+    model_name_ = name;
+    contracted_w_skull_.resize(0);
+
+    if (!same_dimensions)
+    {
+        dragging_ = false;
+        init_parameters(true, true);
+    }
+    evaluate_mlm();
+    update_meshes();
+
+    // the previous model may have been kept only by us
+    registry_.trim();
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void MLMViewer::set_memory_budget(size_t bytes)
+{
+    registry_.set_memory_budget(bytes);
+}
+
+//-----------------------------------------------------------------------------
+
 void MLMViewer::evaluate_mlm()
 {
-    assert( skin_.n_vertices() == 24574);
-    assert( skull_.n_vertices() == 69122);
+    assert( skin_.n_vertices() == mlm_->n_skin_vertices());
+    assert( skull_.n_vertices() == mlm_->n_skull_vertices());
+
+    ScopedTimer timer("viewer/evaluate");
 
-    mlm_.evaluate(skin_, skull_, w_skull_,  w_fstt_);
+    // re-use the skull contraction if only the FSTT parameters changed
+    if (contracted_w_skull_.size() != w_skull_.size() ||
+        contracted_w_skull_ != w_skull_)
+    {
+        mlm_->contract_skull(contracted_, w_skull_);
+        contracted_w_skull_ = w_skull_;
+    }
+    else
+    {
+        Profiler::instance().add_count("viewer/contraction_reused");
+    }
+    mlm_->evaluate_contracted(points_mlm_, contracted_, w_fstt_);
+    mlm_->points_to_meshes(points_mlm_, skin_, skull_);
 }
 
 //-----------------------------------------------------------------------------
 
 void MLMViewer::update_meshes()
 {
+    ScopedTimer timer("viewer/update_opengl_buffers");
+
     // re-compute face and vertex normals
     skin_.update_opengl_buffers();
 
@@ -161,6 +249,25 @@ void MLMViewer::update_points()
 
 //-----------------------------------------------------------------------------
 
+bool MLMViewer::load_points(const std::string& filename)
+{
+    std::vector<float> coordinates;
+    if (!read_points(filename, coordinates))
+    {
+        return false;
+    }
+
+    points_.clear();
+    for (size_t i=0; i+2<coordinates.size(); i+=3)
+    {
+        points_.add_vertex(Point(coordinates[i], coordinates[i+1], coordinates[i+2]));
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
 void MLMViewer::process_imgui()
 {
     if (ImGui::CollapsingHeader("Visibility", ImGuiTreeNodeFlags_DefaultOpen))
@@ -187,7 +294,7 @@ void MLMViewer::process_imgui()
         bool parametersChanged = false;
 
         ImGui::PushItemWidth(100);
-        for (int i=0; i<7; ++i)
+        for (int i=0; i<(int)w_skull_.size(); ++i)
         {
             std::string s = std::string("Skull") + std::to_string(i+1);
             ImGui::Text( "%s", s.data() );
@@ -224,12 +331,12 @@ void MLMViewer::process_imgui()
         bool parametersChanged = false;
 
         ImGui::PushItemWidth(100);
-        for (int i=0; i<4; ++i)
+        for (int i=0; i<(int)w_fstt_.size(); ++i)
         {
             std::string s = std::string("FSTT") + std::to_string(i+1);
             ImGui::Text( "%s", s.data() );
             ImGui::SameLine();
-            ImGui::PushID(7+i);
+            ImGui::PushID((int)w_skull_.size()+i);
             if (ImGui::Button("  +  "))
             {
                 w_fstt_(i) += delta;
@@ -255,15 +362,116 @@ void MLMViewer::process_imgui()
     ImGui::Spacing();
     ImGui::Spacing();
 
+    if (ImGui::CollapsingHeader("Editing"))
+    {
+        ImGui::Checkbox("Drag vertices", &edit_mode_);
+
+        ImGui::PushItemWidth(100);
+        const char* parameters[] = { "Skull + FSTT", "Skull", "FSTT" };
+        ImGui::Combo("Solve for", &edit_parameters_, parameters, 3);
+        ImGui::SliderFloat("Regularization", &edit_regularization_, 0.001f, 1.0f);
+        ImGui::PopItemWidth();
+    }
+
+    ImGui::Spacing();
+    ImGui::Spacing();
+
+    // switch once a model loading in the background is available. the
+    // model is only requested when loaded, such that get() never loads on
+    // the GUI thread.
+    if (!pending_model_.empty())
+    {
+        if (registry_.is_loaded(pending_model_))
+        {
+            switch_mlm(pending_model_);
+            pending_model_.clear();
+        }
+        else if (!registry_.is_loading(pending_model_))
+        {
+            std::cerr << "Cannot load multilinear model " << pending_model_ << std::endl;
+            pending_model_.clear();
+        }
+    }
+
+    if (registry_.names().size() > 1 && ImGui::CollapsingHeader("Models"))
+    {
+        // hot-swap the model, keeping meshes and (if possible) parameters.
+        // models are loaded in the background, such that the GUI stays
+        // responsive while a large tensor is read.
+        for (const std::string& name : registry_.names())
+        {
+            if (ImGui::RadioButton(name.c_str(), name == model_name_))
+            {
+                if (registry_.is_loaded(name))
+                {
+                    switch_mlm(name);
+                }
+                else
+                {
+                    registry_.preload(name);
+                    pending_model_ = name;
+                }
+            }
+            if (registry_.is_loaded(name))
+            {
+                ImGui::SameLine();
+                ImGui::TextDisabled("(loaded)");
+            }
+            else if (registry_.is_loading(name))
+            {
+                ImGui::SameLine();
+                ImGui::TextDisabled("(loading...)");
+            }
+            else
+            {
+                ImGui::SameLine();
+                ImGui::PushID(name.c_str());
+                if (ImGui::SmallButton("Preload"))
+                    registry_.preload(name);
+                ImGui::PopID();
+            }
+        }
+        ImGui::Text("Memory: %.1f MB", registry_.memory_usage() / 1048576.0);
+
+        int budget = int(registry_.memory_budget() / 1048576);
+        ImGui::PushItemWidth(100);
+        if (ImGui::InputInt("Budget (MB)", &budget, 100, 1000))
+            set_memory_budget(size_t(std::max(budget, 0)) * 1048576);
+        ImGui::PopItemWidth();
+    }
+
+    ImGui::Spacing();
+    ImGui::Spacing();
+
     if (ImGui::CollapsingHeader("Misc"))
     {
+        // ASCII OFF (default) or one of the binary MeshExporter formats
+        const char* formats[] = { "OFF (ASCII)", "OFF (binary)", "PLY", "STL", "Raw" };
+        ImGui::PushItemWidth(100);
+        ImGui::Combo("Format", &export_format_, formats, 5);
+        ImGui::PopItemWidth();
+
         if (ImGui::Button("Save meshes"))
         {
-            const std::string filenameSkin  = "mesh_skin_" + std::to_string(conter_save_meshes_) + ".off";
-            const std::string filenameSkull = "mesh_skull_" + std::to_string(conter_save_meshes_) + ".off";
+            if (export_format_ == 0)
+            {
+                const std::string filenameSkin  = "mesh_skin_" + std::to_string(conter_save_meshes_) + ".off";
+                const std::string filenameSkull = "mesh_skull_" + std::to_string(conter_save_meshes_) + ".off";
+                skin_.write(filenameSkin);
+                skull_.write(filenameSkull);
+            }
+            else
+            {
+                // binary formats are written in the background
+                const MeshExporter::Format format = MeshExporter::Format(export_format_ - 1);
+                exporter_.set_output("mesh_", format);
+                if (format == MeshExporter::RAW_FLOAT32)
+                {
+                    exporter_.write_topology("mesh_topology.bin");
+                }
+                exporter_.enqueue(skin_, skull_, conter_save_meshes_);
+            }
             conter_save_meshes_++;
-            skin_.write(filenameSkin);
-            skull_.write(filenameSkull);
         }
 
         if (ImGui::Button("Reset parameters (Skull)"))
@@ -271,7 +479,7 @@ void MLMViewer::process_imgui()
             points_.clear();
             show_points_ = false;
             init_parameters(true, false); // skull only
-            mlm_.evaluate(skin_, skull_, w_skull_,  w_fstt_);
+            evaluate_mlm();
             update_meshes();
         }
 
@@ -280,7 +488,7 @@ void MLMViewer::process_imgui()
             points_.clear();
             show_points_ = false;
             init_parameters(false, true); // FSTT only
-            mlm_.evaluate(skin_, skull_, w_skull_,  w_fstt_);
+            evaluate_mlm();
             update_meshes();
         }
 
@@ -294,6 +502,192 @@ void MLMViewer::process_imgui()
             demo_skin_fit();
         }
     }
+
+    ImGui::Spacing();
+    ImGui::Spacing();
+
+    if (ImGui::CollapsingHeader("Performance"))
+    {
+        Profiler& profiler = Profiler::instance();
+
+        bool enabled = profiler.enabled();
+        if (ImGui::Checkbox("Record timings", &enabled))
+        {
+            profiler.set_enabled(enabled);
+        }
+
+        // per stage: last and mean time, 95th percentile, recent history
+        for (const auto& stage : profiler.stages())
+        {
+            ImGui::Text("%s", stage.name.c_str());
+            ImGui::Text("  last %.2f  mean %.2f  p95 %.2f ms (%lu)",
+                        1000.0 * stage.last, 1000.0 * stage.mean(),
+                        1000.0 * stage.percentile(95.0), stage.count);
+            const std::vector<float> recent = stage.recent_ms();
+            ImGui::PushID(stage.name.c_str());
+            ImGui::PlotLines("", recent.data(), recent.size(), 0, nullptr, 0.0f, FLT_MAX, ImVec2(200, 30));
+            ImGui::PopID();
+        }
+
+        for (const auto& counter : profiler.counters())
+        {
+            ImGui::Text("%s: %lu", counter.first.c_str(), counter.second);
+        }
+
+        if (ImGui::Button("Reset timings"))
+        {
+            profiler.clear();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Save as JSON"))
+        {
+            profiler.write_json("mlm_profile.json");
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void MLMViewer::mouse(int button, int action, int mods)
+{
+    if (edit_mode_ && button == GLFW_MOUSE_BUTTON_LEFT)
+    {
+        if (action == GLFW_PRESS)
+        {
+            double x, y;
+            cursor_pos(x, y);
+            dragging_ = start_drag(x, y);
+            if (dragging_) return;
+        }
+        else if (action == GLFW_RELEASE && dragging_)
+        {
+            dragging_ = false;
+            return;
+        }
+    }
+
+    TrackballViewer::mouse(button, action, mods);
+}
+
+//-----------------------------------------------------------------------------
+
+void MLMViewer::motion(double xpos, double ypos)
+{
+    if (dragging_)
+    {
+        drag_to(xpos, ypos);
+        return;
+    }
+
+    TrackballViewer::motion(xpos, ypos);
+}
+
+//-----------------------------------------------------------------------------
+
+mat4 MLMViewer::mvp_matrix() const
+{
+    return projection_matrix_ * modelview_matrix_;
+}
+
+//-----------------------------------------------------------------------------
+
+bool MLMViewer::start_drag(double x, double y)
+{
+    // surface point under the cursor
+    vec3 p;
+    if (!pick(x, y, p))
+    {
+        return false;
+    }
+
+
+    // closest vertex of the visible meshes
+    float min_dist = FLT_MAX;
+    bool found = false;
+    if (show_skin_)
+    {
+        for (auto v : skin_.vertices())
+        {
+            const float d = sqrnorm(skin_.position(v) - p);
+            if (d < min_dist)
+            {
+                min_dist     = d;
+                drag_vertex_ = v.idx();
+                found        = true;
+            }
+        }
+    }
+    if (show_skull_)
+    {
+        for (auto v : skull_.vertices())
+        {
+            const float d = sqrnorm(skull_.position(v) - p);
+            if (d < min_dist)
+            {
+                min_dist     = d;
+                drag_vertex_ = skin_.n_vertices() + v.idx();
+                found        = true;
+            }
+        }
+    }
+    if (!found)
+    {
+        return false;
+    }
+
+
+    // remember depth of the vertex, the cursor moves it in this plane
+    const unsigned int i = 3*drag_vertex_;
+    vec4 q = mvp_matrix() * vec4(points_mlm_(i), points_mlm_(i+1), points_mlm_(i+2), 1.0f);
+    drag_depth_ = q[2] / q[3];
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void MLMViewer::drag_to(double x, double y)
+{
+    // un-project cursor position at the depth of the dragged vertex
+    const float xf = 2.0f * float(x) / width() - 1.0f;
+    const float yf = 1.0f - 2.0f * float(y) / height();
+    vec4 p = inverse(mvp_matrix()) * vec4(xf, yf, drag_depth_, 1.0f);
+    p /= p[3];
+
+    const unsigned int i = 3*drag_vertex_;
+    const Eigen::Vector3d residual(p[0] - points_mlm_(i),
+                                   p[1] - points_mlm_(i+1),
+                                   p[2] - points_mlm_(i+2));
+
+
+    // Jacobian of the dragged vertex, restricted to the selected parameters
+    const unsigned int dim1 = mlm_->dim1();
+    const unsigned int dim2 = mlm_->dim2();
+    Eigen::MatrixXd J;
+    mlm_->jacobian(J, std::vector<unsigned int>(1, drag_vertex_), w_skull_, w_fstt_);
+
+    const unsigned int first = (edit_parameters_ == 2) ? dim1 : 0;
+    const unsigned int n     = (edit_parameters_ == 0) ? dim1+dim2 :
+                               (edit_parameters_ == 1) ? dim1 : dim2;
+    const Eigen::MatrixXd A = J.middleCols(first, n);
+
+
+    // regularized least squares: (A^T A + lambda I) dw = A^T r
+    Eigen::MatrixXd H = A.transpose() * A;
+    const double lambda = edit_regularization_ * H.trace() / n + 1e-12;
+    H.diagonal().array() += lambda;
+    const Eigen::VectorXd dw = H.ldlt().solve(A.transpose() * residual);
+
+    for (unsigned int j=0; j<n; ++j)
+    {
+        const unsigned int c = first + j;
+        if (c < dim1) w_skull_(c)     += dw(j);
+        else          w_fstt_(c-dim1) += dw(j);
+    }
+
+
+    evaluate_mlm();
+    update_meshes();
 }
 
 //-----------------------------------------------------------------------------
@@ -331,34 +725,34 @@ void MLMViewer::draw(const std::string& drawMode)
 
 void MLMViewer::init_parameters(const bool init_skull, const bool init_fstt)
 {
-    const unsigned int dimMode1 = mlm_.dim1();
-    const unsigned int dimMode2 = mlm_.dim2();
+    const unsigned int dimMode1 = mlm_->dim1();
+    const unsigned int dimMode2 = mlm_->dim2();
     assert(dimMode1 && dimMode2);
 
     if (init_skull)
     {
         w_skull_ = Eigen::VectorXd::Zero(dimMode1);
-        for (unsigned int i = 0; i < mlm_.U_skull().rows(); ++i)
+        for (unsigned int i = 0; i < mlm_->U_skull().rows(); ++i)
         {
-            for (unsigned int j = 0; j < mlm_.U_skull().cols(); ++j)
+            for (unsigned int j = 0; j < mlm_->U_skull().cols(); ++j)
             {
-                w_skull_(j) += mlm_.U_skull()(i, j);
+                w_skull_(j) += mlm_->U_skull()(i, j);
             }
         }
-        w_skull_ /= mlm_.U_skull().rows();
+        w_skull_ /= mlm_->U_skull().rows();
     }
 
     if (init_fstt)
     {
         w_fstt_ = Eigen::VectorXd::Zero(dimMode2);
-        for (unsigned int i = 0; i < mlm_.U_fstt().rows(); ++i)
+        for (unsigned int i = 0; i < mlm_->U_fstt().rows(); ++i)
         {
-            for (unsigned int j = 0; j < mlm_.U_fstt().cols(); ++j)
+            for (unsigned int j = 0; j < mlm_->U_fstt().cols(); ++j)
             {
-                w_fstt_(j) += mlm_.U_fstt()(i, j);
+                w_fstt_(j) += mlm_->U_fstt()(i, j);
             }
         }
-        w_fstt_ /= mlm_.U_fstt().rows();
+        w_fstt_ /= mlm_->U_fstt().rows();
     }
 }
 
@@ -374,12 +768,12 @@ void MLMViewer::demo_skull_fit()
         std::cerr << "Cannot load parameters for w_skull and w_fstt\n";
         return;
     }
-    mlm_.evaluate(skin_, skull_, w_skull_,  w_fstt_);
+    evaluate_mlm();
     update_meshes();
 
 
     // load point set
-    if (!points_.read("../data/mlm_fits2skull/demo_skull_ps.xyz"))
+    if (!load_points("../data/mlm_fits2skull/demo_skull_ps.xyz"))
     {
         std::cerr << "Cannot load points\n";
         return;
@@ -406,12 +800,12 @@ void MLMViewer::demo_skin_fit()
         std::cerr << "Cannot load parameters for w_skull and w_fstt\n";
         return;
     }
-    mlm_.evaluate(skin_, skull_, w_skull_,  w_fstt_);
+    evaluate_mlm();
     update_meshes();
 
 
     // load point set
-    if (!points_.read("../data/mlm_fits2skin/demo_head_ps.xyz"))
+    if (!load_points("../data/mlm_fits2skin/demo_head_ps.xyz"))
     {
         std::cerr << "Cannot load points\n";
         return;
@@ -16,6 +16,8 @@
 #include <pmp/visualization/TrackballViewer.h>
 
 #include "MultilinearModel.h"
+#include "ModelRegistry.h"
+#include "MeshExporter.h"
 
 //=============================================================================
 
@@ -38,6 +40,16 @@ public:
     //! load multilinear model from directory \c dirname
     bool load_mlm(const char* dirname);
 
+    //! register a further multilinear model from directory \c dirname, which
+    //! has to share the topology of the loaded one
+    void add_mlm(const char* dirname);
+
+    //! switch to registered model \c name without reloading the meshes
+    bool switch_mlm(const std::string& name);
+
+    //! set memory budget for loaded models in bytes (0 for unlimited)
+    void set_memory_budget(size_t bytes);
+
     //! evaluate multilinear model
     void evaluate_mlm();
 
@@ -50,12 +62,21 @@ public:
     //! you change the vertex positions of the point set
     void update_points();
 
+    //! load target point set from text (.xyz) or binary (.bxyz) file
+    bool load_points(const std::string& filename);
+
     //! draw the scene
     virtual void draw(const std::string& _draw_mode) override;
 
     //! handle ImGUI interface
     virtual void process_imgui() override;
 
+    //! handle mouse buttons: start/stop dragging a vertex in edit mode
+    virtual void mouse(int button, int action, int mods) override;
+
+    //! handle mouse motion: solve for parameters while dragging a vertex
+    virtual void motion(double xpos, double ypos) override;
+
 private:
 
     //! initialize parameters for skull shape and FSTT distribution
@@ -71,6 +92,17 @@ private:
     //! model fits a target point set of a skin surface
     void demo_skin_fit();
 
+    //! pick the model vertex closest to the surface point under the mouse
+    //! cursor at (x,y) and start dragging it
+    bool start_drag(double x, double y);
+
+    //! move the dragged vertex towards the cursor position (x,y) by a
+    //! regularized least-squares update of the parameters
+    void drag_to(double x, double y);
+
+    //! model-view-projection matrix of the current view
+    mat4 mvp_matrix() const;
+
 protected:
 
     //! the skin mesh of the multilinear model
@@ -80,8 +112,14 @@ protected:
     //! the target as a point set (to demonstrate fitting)
     SurfaceMeshGL points_;
 
-    //! multilinear model
-    MultilinearModel mlm_;
+    //! registered multilinear models
+    ModelRegistry registry_;
+    //! current multilinear model
+    std::shared_ptr<const MultilinearModel> mlm_;
+    //! name of the current model in the registry
+    std::string model_name_;
+    //! model loading in the background, switched to once loaded
+    std::string pending_model_;
 
     //! parameters for skull shape
     Eigen::VectorXd w_skull_;
@@ -99,6 +137,32 @@ protected:
 
     //! counter to save meshes with different filenames
     unsigned int conter_save_meshes_;
+
+    //! switch: left mouse button drags vertices instead of rotating
+    bool edit_mode_;
+    //! parameters solved for while dragging (0: all, 1: skull, 2: FSTT)
+    int edit_parameters_;
+    //! Tikhonov regularization weight, relative to the Jacobian's scale
+    float edit_regularization_;
+    //! is a vertex being dragged?
+    bool dragging_;
+    //! index of dragged vertex (skin vertices first, then skull vertices)
+    unsigned int drag_vertex_;
+    //! normalized device depth of the dragged vertex
+    float drag_depth_;
+
+    //! tensor contracted with w_skull_, re-used while only w_fstt_ changes
+    Eigen::MatrixXd contracted_;
+    //! skull parameters of contracted_
+    Eigen::VectorXd contracted_w_skull_;
+    //! evaluated vertex coordinates
+    Eigen::VectorXd points_mlm_;
+
+    //! background writer for saved meshes
+    MeshExporter exporter_;
+    //! file format for saved meshes: 0 for ASCII OFF, otherwise the
+    //! MeshExporter::Format plus one
+    int export_format_;
 };
 
 //=============================================================================
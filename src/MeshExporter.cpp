@@ -0,0 +1,441 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "MeshExporter.h"
+#include "Profiler.h"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <cassert>
+
+using namespace pmp;
+
+//== HELPER ===================================================================
+
+namespace {
+
+//! append 32 bit word in little-endian byte order
+void put_le(std::vector<char>& buffer, uint32_t w)
+{
+    buffer.push_back(char(w & 0xff));
+    buffer.push_back(char((w >> 8) & 0xff));
+    buffer.push_back(char((w >> 16) & 0xff));
+    buffer.push_back(char((w >> 24) & 0xff));
+}
+
+//! bit pattern of a float
+uint32_t float_bits(float f)
+{
+    uint32_t w;
+    std::memcpy(&w, &f, sizeof(w));
+    return w;
+}
+
+//! append string
+void put_string(std::vector<char>& buffer, const std::string& s)
+{
+    buffer.insert(buffer.end(), s.begin(), s.end());
+}
+
+//! write buffer to file with a single call
+bool write_buffer(const std::string& filename, const char* data, size_t size)
+{
+    FILE* out = fopen(filename.c_str(), "wb");
+    if (!out)
+    {
+        std::cerr << "Cannot write " << filename << std::endl;
+        return false;
+    }
+    const bool ok = (fwrite(data, 1, size, out) == size);
+    return (fclose(out) == 0) && ok;
+}
+
+//! collect triangle indices of a mesh
+bool collect_triangles(const SurfaceMesh& mesh, std::vector<unsigned int>& triangles)
+{
+    triangles.clear();
+    triangles.reserve(3*mesh.n_faces());
+    for (auto f : mesh.faces())
+    {
+        unsigned int n = 0;
+        for (auto v : mesh.vertices(f))
+        {
+            triangles.push_back(v.idx());
+            ++n;
+        }
+        if (n != 3)
+        {
+            std::cerr << "[ERROR] in 'MeshExporter::set_topology(...)' - Meshes have to be triangle meshes" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+
+//== IMPLEMENTATION ============================================================
+
+MeshExporter::
+MeshExporter(unsigned int n_threads, unsigned int max_queued)
+    : n_skin_vertices_(0), n_skull_vertices_(0),
+      prefix_("mesh_"), format_(OFF_BINARY),
+      max_queued_(std::max(max_queued, 1u)),
+      n_active_(0), n_written_(0), n_failed_(0), stop_(false)
+{
+    n_threads = std::max(n_threads, 1u);
+    for (unsigned int i=0; i<n_threads; ++i)
+        threads_.push_back(std::thread(&MeshExporter::worker, this));
+}
+
+//-----------------------------------------------------------------------------
+
+MeshExporter::
+~MeshExporter()
+{
+    finish();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    job_available_.notify_all();
+
+    for (auto& t : threads_)
+        t.join();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+MeshExporter::
+set_topology(const SurfaceMesh& skin, const SurfaceMesh& skull)
+{
+    // wait for pending jobs, since they use the current topology
+    finish();
+
+    if (!collect_triangles(skin, skin_triangles_) ||
+        !collect_triangles(skull, skull_triangles_))
+        return false;
+
+    n_skin_vertices_  = skin.n_vertices();
+    n_skull_vertices_ = skull.n_vertices();
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+MeshExporter::
+set_output(const std::string& prefix, Format format)
+{
+    prefix_ = prefix;
+    format_ = format;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+MeshExporter::
+write_topology(const std::string& filename) const
+{
+    std::vector<char> buffer;
+    buffer.reserve(16 + 4*(skin_triangles_.size() + skull_triangles_.size()));
+
+    put_le(buffer, n_skin_vertices_);
+    put_le(buffer, n_skull_vertices_);
+    put_le(buffer, skin_triangles_.size()/3);
+    put_le(buffer, skull_triangles_.size()/3);
+    for (auto i : skin_triangles_)  put_le(buffer, i);
+    for (auto i : skull_triangles_) put_le(buffer, i);
+
+    return write_buffer(filename, buffer.data(), buffer.size());
+}
+
+//-----------------------------------------------------------------------------
+
+void
+MeshExporter::
+enqueue(const Eigen::VectorXd& points, unsigned int index)
+{
+    assert(points.size() == 3*(n_skin_vertices_ + n_skull_vertices_));
+
+    Job job;
+    job.points.resize(points.size());
+    for (int i=0; i<points.size(); ++i)
+        job.points[i] = float(points(i));
+    job.index = index;
+    push(job);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+MeshExporter::
+enqueue(const SurfaceMesh& skin, const SurfaceMesh& skull, unsigned int index)
+{
+    assert(skin.n_vertices()  == n_skin_vertices_);
+    assert(skull.n_vertices() == n_skull_vertices_);
+
+    Job job;
+    job.points.reserve(3*(n_skin_vertices_ + n_skull_vertices_));
+    for (auto v : skin.vertices())
+    {
+        const Point& p = skin.position(v);
+        job.points.push_back(p[0]);
+        job.points.push_back(p[1]);
+        job.points.push_back(p[2]);
+    }
+    for (auto v : skull.vertices())
+    {
+        const Point& p = skull.position(v);
+        job.points.push_back(p[0]);
+        job.points.push_back(p[1]);
+        job.points.push_back(p[2]);
+    }
+    job.index = index;
+    push(job);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+MeshExporter::
+push(Job& job)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    job_done_.wait(lock, [this]{ return queue_.size() < max_queued_; });
+
+    job.prefix = prefix_;
+    job.format = format_;
+    queue_.push_back(std::move(job));
+
+    lock.unlock();
+    job_available_.notify_one();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+MeshExporter::
+finish()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    job_done_.wait(lock, [this]{ return queue_.empty() && n_active_ == 0; });
+}
+
+//-----------------------------------------------------------------------------
+
+unsigned int
+MeshExporter::
+n_written() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return n_written_;
+}
+
+//-----------------------------------------------------------------------------
+
+unsigned int
+MeshExporter::
+n_failed() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return n_failed_;
+}
+
+//-----------------------------------------------------------------------------
+
+const char*
+MeshExporter::
+extension(Format format)
+{
+    switch (format)
+    {
+        case OFF_BINARY:  return ".off";
+        case PLY_BINARY:  return ".ply";
+        case STL_BINARY:  return ".stl";
+        case RAW_FLOAT32: return ".raw";
+    }
+    return "";
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+MeshExporter::
+parse_format(const std::string& name, Format& format)
+{
+    if      (name == "off") format = OFF_BINARY;
+    else if (name == "ply") format = PLY_BINARY;
+    else if (name == "stl") format = STL_BINARY;
+    else if (name == "raw") format = RAW_FLOAT32;
+    else return false;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+MeshExporter::
+worker()
+{
+    while (true)
+    {
+        Job job;
+
+        // wait for next job
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            job_available_.wait(lock, [this]{ return stop_ || !queue_.empty(); });
+            if (queue_.empty())
+                return;
+            job = std::move(queue_.front());
+            queue_.pop_front();
+            ++n_active_;
+        }
+        job_done_.notify_all();
+
+        const bool ok = write(job);
+
+        // update statistics
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --n_active_;
+            if (ok) ++n_written_;
+            else    ++n_failed_;
+        }
+        job_done_.notify_all();
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+MeshExporter::
+write(const Job& job) const
+{
+    ScopedTimer timer("export/write");
+
+    const std::string index = std::to_string(job.index);
+    const char* ext = extension(job.format);
+
+    if (job.format == RAW_FLOAT32)
+    {
+        return write_buffer(job.prefix + index + ext,
+                            reinterpret_cast<const char*>(job.points.data()),
+                            job.points.size()*sizeof(float));
+    }
+
+    return write_mesh(job.prefix + "skin_" + index + ext, job.format,
+                      &job.points[0], n_skin_vertices_, skin_triangles_) &&
+           write_mesh(job.prefix + "skull_" + index + ext, job.format,
+                      &job.points[3*n_skin_vertices_], n_skull_vertices_, skull_triangles_);
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+MeshExporter::
+write_mesh(const std::string& filename, Format format,
+           const float* points, unsigned int n_vertices,
+           const std::vector<unsigned int>& triangles)
+{
+    const unsigned int n_triangles = triangles.size()/3;
+    std::vector<char> buffer;
+
+    switch (format)
+    {
+        case OFF_BINARY:
+        {
+            // binary OFF in the dialect read by pmp::SurfaceMesh, i.e.,
+            // native little-endian words and no color count per face
+            buffer.reserve(32 + 12*n_vertices + 16*n_triangles);
+            put_string(buffer, "OFF BINARY\n");
+            put_le(buffer, n_vertices);
+            put_le(buffer, n_triangles);
+            put_le(buffer, 0);
+            for (unsigned int i=0; i<3*n_vertices; ++i)
+                put_le(buffer, float_bits(points[i]));
+            for (unsigned int i=0; i<n_triangles; ++i)
+            {
+                put_le(buffer, 3);
+                put_le(buffer, triangles[3*i+0]);
+                put_le(buffer, triangles[3*i+1]);
+                put_le(buffer, triangles[3*i+2]);
+            }
+            break;
+        }
+
+        case PLY_BINARY:
+        {
+            buffer.reserve(256 + 12*n_vertices + 13*n_triangles);
+            put_string(buffer, "ply\n"
+                               "format binary_little_endian 1.0\n"
+                               "element vertex " + std::to_string(n_vertices) + "\n"
+                               "property float x\n"
+                               "property float y\n"
+                               "property float z\n"
+                               "element face " + std::to_string(n_triangles) + "\n"
+                               "property list uchar int vertex_indices\n"
+                               "end_header\n");
+            for (unsigned int i=0; i<3*n_vertices; ++i)
+                put_le(buffer, float_bits(points[i]));
+            for (unsigned int i=0; i<n_triangles; ++i)
+            {
+                buffer.push_back(char(3));
+                put_le(buffer, triangles[3*i+0]);
+                put_le(buffer, triangles[3*i+1]);
+                put_le(buffer, triangles[3*i+2]);
+            }
+            break;
+        }
+
+        case STL_BINARY:
+        {
+            buffer.reserve(84 + 50*n_triangles);
+            buffer.resize(80, 0);
+            put_le(buffer, n_triangles);
+            for (unsigned int i=0; i<n_triangles; ++i)
+            {
+                const float* p0 = points + 3*triangles[3*i+0];
+                const float* p1 = points + 3*triangles[3*i+1];
+                const float* p2 = points + 3*triangles[3*i+2];
+
+                // face normal
+                const Point e1(p1[0]-p0[0], p1[1]-p0[1], p1[2]-p0[2]);
+                const Point e2(p2[0]-p0[0], p2[1]-p0[1], p2[2]-p0[2]);
+                const Point n = normalize(cross(e1, e2));
+
+                for (int j=0; j<3; ++j) put_le(buffer, float_bits(n[j]));
+                for (int j=0; j<3; ++j) put_le(buffer, float_bits(p0[j]));
+                for (int j=0; j<3; ++j) put_le(buffer, float_bits(p1[j]));
+                for (int j=0; j<3; ++j) put_le(buffer, float_bits(p2[j]));
+                buffer.push_back(0);
+                buffer.push_back(0);
+            }
+            break;
+        }
+
+        default:
+            return false;
+    }
+
+    return write_buffer(filename, buffer.data(), buffer.size());
+}
+
+//=============================================================================
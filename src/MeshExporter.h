@@ -0,0 +1,146 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+//== INCLUDES =================================================================
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <Eigen/Dense>
+#include <pmp/SurfaceMesh.h>
+
+
+//== CLASS DEFINITION =========================================================
+
+//! Streaming exporter for evaluated skin/skull meshes. Samples are queued as
+//! flat coordinate vectors (as returned by MultilinearModel::evaluate) and
+//! written in a binary format by background I/O threads, such that the
+//! evaluation of the next sample overlaps with writing the previous one.
+class MeshExporter
+{
+public:
+
+    //! output file formats
+    enum Format
+    {
+        OFF_BINARY,  //!< binary OFF as read by pmp::SurfaceMesh ("OFF BINARY" header)
+        PLY_BINARY,  //!< binary little-endian PLY
+        STL_BINARY,  //!< binary STL (per-face normals, no shared vertices)
+        RAW_FLOAT32  //!< raw native float32 vertex dump, topology in a separate file
+    };
+
+    //! constructor. \c n_threads I/O threads write files, at most
+    //! \c max_queued samples are buffered before enqueue() blocks.
+    MeshExporter(unsigned int n_threads = 2, unsigned int max_queued = 8);
+
+    //! destructor, waits for all queued samples to be written
+    ~MeshExporter();
+
+    //! set triangle topology of skin and skull, which is shared by all samples
+    bool set_topology(const pmp::SurfaceMesh& skin, const pmp::SurfaceMesh& skull);
+
+    //! set output format and filename prefix. mesh formats write the files
+    //! <prefix>skin_<index>.<ext> and <prefix>skull_<index>.<ext>,
+    //! RAW_FLOAT32 writes <prefix><index>.raw
+    void set_output(const std::string& prefix, Format format);
+
+    //! write topology file for raw vertex dumps: four uint32 counts (skin
+    //! vertices, skull vertices, skin triangles, skull triangles) followed by
+    //! the uint32 vertex indices of skin and skull triangles
+    bool write_topology(const std::string& filename) const;
+
+    //! queue a sample for writing. blocks while the queue is full.
+    void enqueue(const Eigen::VectorXd& points, unsigned int index);
+
+    //! queue the current vertex positions of skin and skull meshes
+    void enqueue(const pmp::SurfaceMesh& skin, const pmp::SurfaceMesh& skull,
+                 unsigned int index);
+
+    //! block until all queued samples have been written
+    void finish();
+
+    //! number of samples written so far
+    unsigned int n_written() const;
+
+    //! number of samples that could not be written
+    unsigned int n_failed() const;
+
+    //! file extension for format \c format
+    static const char* extension(Format format);
+
+    //! parse format name ("off", "ply", "stl", "raw")
+    static bool parse_format(const std::string& name, Format& format);
+
+private:
+
+    //! one queued sample
+    struct Job
+    {
+        std::vector<float> points;
+        unsigned int index;
+        std::string prefix;
+        Format format;
+    };
+
+    //! I/O thread main loop
+    void worker();
+
+    //! write one sample
+    bool write(const Job& job) const;
+
+    //! write a triangle mesh in one of the mesh formats
+    static bool write_mesh(const std::string& filename, Format format,
+                           const float* points, unsigned int n_vertices,
+                           const std::vector<unsigned int>& triangles);
+
+    //! enqueue a job that already has its points filled in
+    void push(Job& job);
+
+private:
+
+    //! triangle indices for skin and skull (skull indices start at 0)
+    std::vector<unsigned int> skin_triangles_, skull_triangles_;
+    //! number of skin and skull vertices
+    unsigned int n_skin_vertices_, n_skull_vertices_;
+
+    //! output filename prefix
+    std::string prefix_;
+    //! output format
+    Format format_;
+
+    //! I/O threads
+    std::vector<std::thread> threads_;
+    //! queued samples
+    std::deque<Job> queue_;
+    //! maximum number of queued samples
+    unsigned int max_queued_;
+    //! number of samples currently being written
+    unsigned int n_active_;
+    //! statistics
+    unsigned int n_written_, n_failed_;
+    //! signal threads to terminate
+    bool stop_;
+
+    //! protects queue and statistics
+    mutable std::mutex mutex_;
+    //! signals new jobs or termination to I/O threads
+    std::condition_variable job_available_;
+    //! signals free queue slots and completed jobs
+    std::condition_variable job_done_;
+};
+
+//=============================================================================
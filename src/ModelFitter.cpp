@@ -0,0 +1,211 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "ModelFitter.h"
+#include "Profiler.h"
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+//== IMPLEMENTATION ============================================================
+
+ModelFitter::
+ModelFitter(const MultilinearModel& mlm)
+    : mlm_(mlm), cache_(mlm), part_(SKULL), step_(1),
+      matched_valid_(false),
+      correspondence_tolerance_(0.0), regularization_(0.01)
+{
+    counters_.correspondence_hits = counters_.correspondence_misses = 0;
+    set_part(SKULL);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ModelFitter::
+set_target(const std::vector<float>& points)
+{
+    target_ = Eigen::Map<const Eigen::MatrixXf>(points.data(), 3, points.size()/3).cast<double>();
+    tree_.build(target_);
+    matched_valid_ = false;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ModelFitter::
+set_part(Part part)
+{
+    part_ = part;
+
+    const unsigned int first = (part_ == SKIN) ? 0 : mlm_.n_skin_vertices();
+    const unsigned int count = (part_ == SKIN) ? mlm_.n_skin_vertices() : mlm_.n_skull_vertices();
+    vertices_.clear();
+    for (unsigned int v=0; v<count; v+=step_)
+        vertices_.push_back(first + v);
+
+    matched_valid_ = false;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ModelFitter::
+set_subsampling(unsigned int step)
+{
+    step_ = std::max(step, 1u);
+    set_part(part_);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ModelFitter::
+update_correspondences(const Eigen::Matrix3Xd& positions)
+{
+    const unsigned int n = vertices_.size();
+
+    // reuse correspondences while no vertex moved farther than the tolerance
+    if (matched_valid_)
+    {
+        const double motion = (positions - matched_positions_).colwise().squaredNorm().maxCoeff();
+        if (std::sqrt(motion) <= correspondence_tolerance_)
+        {
+            ++counters_.correspondence_hits;
+            Profiler::instance().add_count("fit/correspondence_hit");
+            return;
+        }
+    }
+
+    ScopedTimer timer("fit/correspondences");
+    ++counters_.correspondence_misses;
+    Profiler::instance().add_count("fit/correspondence_miss");
+
+
+    // closest target point of each model vertex
+    std::vector<KdTree::Neighbor> closest(n);
+    matched_positions_ = positions;
+#pragma omp parallel for
+    for (int i=0; i<(int)n; ++i)
+    {
+        const Eigen::Vector3d p = positions.col(i);
+        closest[i] = tree_.nearest(p);
+    }
+
+
+    // reject pairs much farther apart than the median, e.g. where the
+    // target is incomplete
+    std::vector<double> distances(n);
+    for (unsigned int i=0; i<n; ++i)
+        distances[i] = closest[i].first;
+    std::nth_element(distances.begin(), distances.begin() + n/2, distances.end());
+    const double max_distance = 6.25 * distances[n/2]; // (2.5 * median)^2
+
+    matched_.clear();
+    std::vector<unsigned int> target_index;
+    for (unsigned int i=0; i<n; ++i)
+    {
+        if (closest[i].first <= max_distance)
+        {
+            matched_.push_back(i);
+            target_index.push_back(closest[i].second);
+        }
+    }
+
+    matched_targets_.resize(3, matched_.size());
+    for (unsigned int i=0; i<matched_.size(); ++i)
+        matched_targets_.col(i) = target_.col(target_index[i]);
+
+    matched_valid_ = true;
+}
+
+//-----------------------------------------------------------------------------
+
+double
+ModelFitter::
+fit(Eigen::VectorXd& w_skull, Eigen::VectorXd& w_fstt, unsigned int max_iterations)
+{
+    assert(w_skull.size() == mlm_.dim1());
+    assert(w_fstt.size()  == mlm_.dim2());
+
+    if (!tree_.size() || vertices_.empty())
+    {
+        std::cerr << "[ERROR] in 'ModelFitter::fit(...)' - No target or model vertices" << std::endl;
+        return -1.0;
+    }
+
+    const unsigned int dim1 = mlm_.dim1(), dim2 = mlm_.dim2();
+    double rms = 0.0;
+
+    for (unsigned int iter=0; iter<=max_iterations; ++iter)
+    {
+        ScopedTimer timer("fit/iteration");
+
+        const Eigen::VectorXd& points = cache_.evaluate(w_skull, w_fstt);
+
+        // the evaluation may come from a contraction with slightly different
+        // skull parameters. the model is linear in them, so the skull columns
+        // of the Jacobian give the exact positions of the fitted vertices,
+        // which are used for both correspondences and residuals.
+        Eigen::MatrixXd J_all;
+        cache_.jacobian(J_all, vertices_, w_skull, w_fstt);
+        const Eigen::VectorXd correction =
+            J_all.leftCols(dim1) * (w_skull - cache_.contraction_parameters());
+
+        const unsigned int n = vertices_.size();
+        Eigen::Matrix3Xd positions(3, n);
+        for (unsigned int i=0; i<n; ++i)
+        {
+            const unsigned int v = vertices_[i];
+            for (unsigned int d=0; d<3; ++d)
+                positions(d,i) = points(3*v+d) + correction(3*i+d);
+        }
+        update_correspondences(positions);
+
+        const unsigned int m = matched_.size();
+        if (!m)
+            break;
+
+        Eigen::MatrixXd J(3*m, dim1 + dim2);
+        Eigen::VectorXd residual(3*m);
+        for (unsigned int r=0; r<m; ++r)
+        {
+            const unsigned int i = matched_[r];
+            J.middleRows(3*r, 3) = J_all.middleRows(3*i, 3);
+            residual.segment(3*r, 3) = matched_targets_.col(r) - positions.col(i);
+        }
+        rms = std::sqrt(residual.squaredNorm() / m);
+
+        if (iter == max_iterations)
+            break;
+
+
+        // regularized Gauss-Newton step: (J^T J + lambda I) dw = J^T r
+        Eigen::MatrixXd H = J.transpose() * J;
+        const double lambda = regularization_ * H.trace() / H.rows() + 1e-12;
+        H.diagonal().array() += lambda;
+        const Eigen::VectorXd dw = H.ldlt().solve(J.transpose() * residual);
+
+        w_skull += dw.head(dim1);
+        w_fstt  += dw.tail(dim2);
+
+        Eigen::VectorXd w(dim1 + dim2);
+        w << w_skull, w_fstt;
+        if (dw.norm() <= 1e-8 * w.norm())
+            break;
+    }
+
+    return rms;
+}
+
+//=============================================================================
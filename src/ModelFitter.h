@@ -0,0 +1,116 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+//== INCLUDES =================================================================
+
+#include <vector>
+#include <Eigen/Dense>
+
+#include "MultilinearModel.h"
+#include "EvaluationCache.h"
+#include "KdTree.h"
+
+
+//== CLASS DEFINITION =========================================================
+
+//! Gauss-Newton fit of the model's skin or skull to a target point set.
+//! Each iteration matches (a subset of) the model vertices to their closest
+//! target points and solves a regularized linear least-squares problem for
+//! the parameter update. Evaluations and Jacobians go through an
+//! EvaluationCache; correspondences are reused until a model vertex has
+//! moved farther than a distance tolerance since they were computed.
+class ModelFitter
+{
+public:
+
+    //! which mesh of the model is fitted to the target
+    enum Part { SKIN, SKULL };
+
+    //! hit and miss counters of the correspondence cache
+    struct Counters
+    {
+        unsigned long correspondence_hits, correspondence_misses;
+    };
+
+    //! constructor
+    ModelFitter(const MultilinearModel& mlm);
+
+    //! set target points x0,y0,z0,x1,...
+    void set_target(const std::vector<float>& points);
+
+    //! fit skin or skull (default: skull)
+    void set_part(Part part);
+
+    //! use every step-th vertex of the fitted mesh (default 1)
+    void set_subsampling(unsigned int step);
+
+    //! relative skull parameter change below which the contraction is reused (default 0)
+    void set_parameter_tolerance(double tolerance) { cache_.set_tolerance(tolerance); }
+
+    //! vertex motion below which correspondences are reused (default 0)
+    void set_correspondence_tolerance(double distance) { correspondence_tolerance_ = distance; }
+
+    //! Tikhonov regularization weight, relative to the scale of J^T J (default 0.01)
+    void set_regularization(double weight) { regularization_ = weight; }
+
+    //! fit, starting from and updating 'w_skull' and 'w_fstt'. returns the
+    //! final RMS distance between matched model vertices and target points.
+    double fit(Eigen::VectorXd& w_skull, Eigen::VectorXd& w_fstt,
+               unsigned int max_iterations = 20);
+
+    //! the evaluation cache
+    const EvaluationCache& cache() const { return cache_; }
+
+    //! correspondence cache counters
+    const Counters& counters() const { return counters_; }
+
+private:
+
+    //! update correspondences for the current positions of vertices_
+    void update_correspondences(const Eigen::Matrix3Xd& positions);
+
+private:
+
+    //! the multilinear model
+    const MultilinearModel& mlm_;
+    //! caching evaluation layer
+    EvaluationCache cache_;
+
+    //! target points and their k-d tree
+    Eigen::MatrixXd target_;
+    KdTree tree_;
+
+    //! fitted model vertices (indices into skin and skull vertices)
+    std::vector<unsigned int> vertices_;
+    //! fitted part and subsampling step
+    Part part_;
+    unsigned int step_;
+
+    //! matched vertices (indices into vertices_) and their target points
+    std::vector<unsigned int> matched_;
+    Eigen::Matrix3Xd matched_targets_;
+    //! positions of vertices_ when correspondences were computed
+    Eigen::Matrix3Xd matched_positions_;
+    //! correspondences are valid
+    bool matched_valid_;
+
+    //! tolerances and regularization
+    double correspondence_tolerance_;
+    double regularization_;
+
+    //! correspondence cache counters
+    Counters counters_;
+};
+
+//=============================================================================
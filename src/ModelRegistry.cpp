@@ -0,0 +1,458 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "ModelRegistry.h"
+#include "PointCloudIO.h"
+#include "Profiler.h"
+#include <iostream>
+
+using namespace pmp;
+
+//== HELPER ===================================================================
+
+namespace {
+
+//! 64 bit FNV-1a hash of a buffer
+uint64_t hash(const std::vector<char>& buffer, uint64_t h = 14695981039346656037ull)
+{
+    for (char c : buffer)
+    {
+        h ^= (unsigned char)c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+} // anonymous namespace
+
+
+//== IMPLEMENTATION ============================================================
+
+ModelRegistry::
+ModelRegistry()
+    : budget_(0), clock_(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+ModelRegistry::
+~ModelRegistry()
+{
+    for (auto& t : threads_)
+        t.first.join();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ModelRegistry::
+add(const std::string& name, const std::string& dirname)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Entry& e = entries_[name];
+    e.dirname = dirname;
+    e.model.reset();
+    e.topology.reset();
+    e.loading = std::shared_future<Loaded>();
+    e.generation = ++clock_;
+    e.memory = 0;
+    e.last_used = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ModelRegistry::
+remove(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.erase(name);
+}
+
+//-----------------------------------------------------------------------------
+
+std::shared_ptr<const MultilinearModel>
+ModelRegistry::
+get(const std::string& name)
+{
+    std::shared_future<Loaded> loading;
+    std::shared_ptr<std::promise<Loaded> > promise;
+    std::string dirname;
+    uint64_t generation = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = entries_.find(name);
+        if (it == entries_.end())
+        {
+            std::cerr << "[ERROR] in 'ModelRegistry::get(...)' - Unknown model " << name << std::endl;
+            return nullptr;
+        }
+
+        Entry& e = it->second;
+        e.last_used = ++clock_;
+        if (e.model)
+        {
+            Profiler::instance().add_count("registry/hit");
+            return e.model;
+        }
+
+        // the first caller loads, further callers wait for its result
+        if (!e.loading.valid())
+            promise = start_load(e);
+        loading    = e.loading;
+        dirname    = e.dirname;
+        generation = e.generation;
+    }
+
+    if (promise)
+        finish_load(name, dirname, generation, promise);
+
+    return loading.get().model;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ModelRegistry::
+preload(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // join threads that have finished loading
+    for (auto it = threads_.begin(); it != threads_.end(); )
+    {
+        if (it->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            it->first.join();
+            it = threads_.erase(it);
+        }
+        else ++it;
+    }
+
+    auto it = entries_.find(name);
+    if (it == entries_.end() || it->second.model || it->second.loading.valid())
+        return;
+
+    // the entry is marked as loading before this function returns, such
+    // that get() called meanwhile waits instead of loading a second time
+    Entry& e = it->second;
+    e.last_used = ++clock_;
+    std::shared_ptr<std::promise<Loaded> > promise = start_load(e);
+    const std::string dirname = e.dirname;
+    const uint64_t generation = e.generation;
+
+    threads_.push_back(std::make_pair(
+        std::thread(&ModelRegistry::finish_load, this, name, dirname, generation, promise),
+        e.loading));
+}
+
+//-----------------------------------------------------------------------------
+
+std::shared_ptr<std::promise<ModelRegistry::Loaded> >
+ModelRegistry::
+start_load(Entry& e)
+{
+    std::shared_ptr<std::promise<Loaded> > promise = std::make_shared<std::promise<Loaded> >();
+    e.loading = promise->get_future().share();
+    return promise;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ModelRegistry::
+finish_load(const std::string& name, const std::string& dirname, uint64_t generation,
+            std::shared_ptr<std::promise<Loaded> > promise)
+{
+    Loaded loaded;
+    try
+    {
+        loaded = load(dirname);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "[ERROR] in 'ModelRegistry::finish_load(...)' - Can't load model from " << dirname << ": " << e.what() << std::endl;
+        loaded = Loaded();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // store the model unless the entry was replaced meanwhile. on
+        // failure, the entry is no longer loading and a later get() retries.
+        auto it = entries_.find(name);
+        if (it != entries_.end() && it->second.generation == generation)
+        {
+            Entry& e = it->second;
+            e.loading = std::shared_future<Loaded>();
+            if (loaded.model)
+            {
+                e.model    = loaded.model;
+                e.topology = loaded.topology;
+                e.memory   = loaded.model->memory_usage();
+                evict(name);
+            }
+        }
+    }
+
+    // waiters always get a result, a null model on failure
+    promise->set_value(loaded);
+}
+
+//-----------------------------------------------------------------------------
+
+std::shared_ptr<const ModelRegistry::Topology>
+ModelRegistry::
+topology(const std::string& name)
+{
+    if (!get(name))
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(name);
+    return (it != entries_.end()) ? it->second.topology : nullptr;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+ModelRegistry::
+is_loaded(const std::string& name) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(name);
+    return (it != entries_.end()) && it->second.model;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+ModelRegistry::
+is_loading(const std::string& name) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(name);
+    return (it != entries_.end()) && it->second.loading.valid();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ModelRegistry::
+unload(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(name);
+    if (it != entries_.end())
+    {
+        it->second.model.reset();
+        it->second.topology.reset();
+        it->second.loading = std::shared_future<Loaded>();
+        it->second.generation = ++clock_;
+        it->second.memory = 0;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+std::vector<std::string>
+ModelRegistry::
+names() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> result;
+    for (const auto& e : entries_)
+        result.push_back(e.first);
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ModelRegistry::
+set_memory_budget(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    budget_ = bytes;
+    evict("");
+}
+
+//-----------------------------------------------------------------------------
+
+size_t
+ModelRegistry::
+memory_budget() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return budget_;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ModelRegistry::
+trim()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    evict("");
+}
+
+//-----------------------------------------------------------------------------
+
+size_t
+ModelRegistry::
+memory_usage() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t bytes = 0;
+    for (const auto& e : entries_)
+        bytes += e.second.memory;
+    return bytes;
+}
+
+//-----------------------------------------------------------------------------
+
+ModelRegistry::Loaded
+ModelRegistry::
+load(const std::string& dirname)
+{
+    ScopedTimer timer("registry/load");
+
+    Loaded loaded;
+    std::shared_ptr<const Topology> topology = load_topology(dirname);
+    if (!topology)
+        return loaded;
+
+    std::shared_ptr<MultilinearModel> model = std::make_shared<MultilinearModel>();
+    model->set_means(topology->mean, topology->skin.n_vertices(), topology->skull.n_vertices());
+    if (!model->load(dirname))
+    {
+        std::cerr << "[ERROR] in 'ModelRegistry::load(...)' - Can't load model from " << dirname << std::endl;
+        return loaded;
+    }
+
+    loaded.model    = model;
+    loaded.topology = topology;
+    return loaded;
+}
+
+//-----------------------------------------------------------------------------
+
+std::shared_ptr<const ModelRegistry::Topology>
+ModelRegistry::
+load_topology(const std::string& dirname)
+{
+    // identify mean meshes by their file contents
+    std::vector<char> skin_file, skull_file;
+    if (!read_file(dirname + "skin.off", skin_file) ||
+        !read_file(dirname + "skull.off", skull_file))
+    {
+        std::cerr << "[ERROR] in 'ModelRegistry::load_topology(...)' - Can't read mean meshes in " << dirname << std::endl;
+        return nullptr;
+    }
+    const uint64_t key = hash(skull_file, hash(skin_file));
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::shared_ptr<const Topology> shared = topologies_[key].lock();
+        if (shared)
+        {
+            Profiler::instance().add_count("registry/shared_topology");
+            return shared;
+        }
+    }
+
+
+    // load meshes and build mean vector (skin first, then skull)
+    std::shared_ptr<Topology> topology = std::make_shared<Topology>();
+    if (!topology->skin.read(dirname + "skin.off") ||
+        !topology->skull.read(dirname + "skull.off"))
+    {
+        std::cerr << "[ERROR] in 'ModelRegistry::load_topology(...)' - Can't load mean meshes in " << dirname << std::endl;
+        return nullptr;
+    }
+
+    std::shared_ptr<std::vector<double> > mean = std::make_shared<std::vector<double> >();
+    mean->reserve(3*(topology->skin.n_vertices() + topology->skull.n_vertices()));
+    for (auto v : topology->skin.vertices())
+    {
+        const Point& p = topology->skin.position(v);
+        mean->push_back(p[0]);
+        mean->push_back(p[1]);
+        mean->push_back(p[2]);
+    }
+    for (auto v : topology->skull.vertices())
+    {
+        const Point& p = topology->skull.position(v);
+        mean->push_back(p[0]);
+        mean->push_back(p[1]);
+        mean->push_back(p[2]);
+    }
+    topology->mean = mean;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // another thread may have loaded the same meshes meanwhile
+    std::shared_ptr<const Topology> shared = topologies_[key].lock();
+    if (shared)
+    {
+        Profiler::instance().add_count("registry/shared_topology");
+        return shared;
+    }
+
+    // forget topologies that are no longer used
+    for (auto it = topologies_.begin(); it != topologies_.end(); )
+    {
+        if (it->second.expired()) it = topologies_.erase(it);
+        else ++it;
+    }
+    topologies_[key] = topology;
+    return topology;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ModelRegistry::
+evict(const std::string& keep)
+{
+    if (!budget_)
+        return;
+
+    while (true)
+    {
+        size_t bytes = 0;
+        Entry* oldest = nullptr;
+        for (auto& e : entries_)
+        {
+            // models still held elsewhere would not be freed
+            bytes += e.second.memory;
+            if (e.second.model && e.second.model.use_count() == 1 && e.first != keep &&
+                (!oldest || e.second.last_used < oldest->last_used))
+                oldest = &e.second;
+        }
+
+        if (bytes <= budget_ || !oldest)
+            return;
+
+        oldest->model.reset();
+        oldest->topology.reset();
+        oldest->memory = 0;
+        Profiler::instance().add_count("registry/evicted");
+    }
+}
+
+//=============================================================================
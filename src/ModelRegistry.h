@@ -0,0 +1,163 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+//== INCLUDES =================================================================
+
+#include "MultilinearModel.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <pmp/SurfaceMesh.h>
+
+
+//== CLASS DEFINITION =========================================================
+
+//! Registry of several multilinear models (e.g. reduced and full models, or
+//! different versions), addressed by name and loaded on demand or in the
+//! background. Models whose mean meshes are identical share mean geometry and
+//! topology. Loaded models that are not in use elsewhere are evicted in
+//! least-recently-used order when they exceed the memory budget. Models are
+//! handed out as shared pointers, so evaluations that still use a replaced
+//! model finish safely. All methods are thread-safe; loading does not block
+//! calls for other models.
+class ModelRegistry
+{
+public:
+
+    //! mean skin and skull meshes shared by models of the same topology
+    struct Topology
+    {
+        pmp::SurfaceMesh skin, skull;
+        std::shared_ptr<const std::vector<double> > mean;
+    };
+
+    //! constructor
+    ModelRegistry();
+
+    //! destructor, waits for background loads
+    ~ModelRegistry();
+
+    //! register model directory 'dirname' (containing skin.off, skull.off,
+    //! and the model files) under 'name'. the model is loaded on first use.
+    //! registering an existing name replaces the model.
+    void add(const std::string& name, const std::string& dirname);
+
+    //! remove model 'name' from the registry
+    void remove(const std::string& name);
+
+    //! get model 'name', loading it if necessary. if the model is being
+    //! loaded by another thread, waits for it. returns a null pointer if
+    //! the model is not registered or cannot be loaded.
+    std::shared_ptr<const MultilinearModel> get(const std::string& name);
+
+    //! start loading model 'name' in a background thread. once this returns,
+    //! is_loading() is true until the model is loaded or loading failed.
+    void preload(const std::string& name);
+
+    //! get mean skin and skull meshes of model 'name', loading it if necessary
+    std::shared_ptr<const Topology> topology(const std::string& name);
+
+    //! is model 'name' currently loaded?
+    bool is_loaded(const std::string& name) const;
+
+    //! is model 'name' currently being loaded?
+    bool is_loading(const std::string& name) const;
+
+    //! drop model 'name' from memory, keeping it registered
+    void unload(const std::string& name);
+
+    //! names of all registered models
+    std::vector<std::string> names() const;
+
+    //! set memory budget for loaded models in bytes (0 for unlimited)
+    void set_memory_budget(size_t bytes);
+
+    //! get memory budget in bytes (0 for unlimited)
+    size_t memory_budget() const;
+
+    //! evict unused models until the budget is met, e.g. after a model
+    //! handed out earlier has been released
+    void trim();
+
+    //! memory used by the loaded models in bytes
+    size_t memory_usage() const;
+
+private:
+
+    //! a loaded model and its mean meshes
+    struct Loaded
+    {
+        std::shared_ptr<const MultilinearModel> model;
+        std::shared_ptr<const Topology> topology;
+    };
+
+    //! one registered model
+    struct Entry
+    {
+        std::string dirname;
+        std::shared_ptr<const MultilinearModel> model;
+        std::shared_ptr<const Topology> topology;
+        //! result of a load in progress (invalid if none)
+        std::shared_future<Loaded> loading;
+        //! incremented when the entry is replaced or unloaded, such that
+        //! outdated loads are discarded
+        uint64_t generation;
+        size_t memory;
+        uint64_t last_used;
+    };
+
+    //! mark entry 'e' as loading and return the promise for its result.
+    //! requires the lock to be held.
+    std::shared_ptr<std::promise<Loaded> > start_load(Entry& e);
+
+    //! load the model of entry 'name' (without holding the lock), store it
+    //! unless the entry changed since 'generation', and fulfill 'promise'
+    void finish_load(const std::string& name, const std::string& dirname, uint64_t generation,
+                     std::shared_ptr<std::promise<Loaded> > promise);
+
+    //! load the model in directory 'dirname', without holding the lock
+    Loaded load(const std::string& dirname);
+
+    //! get mean meshes of directory 'dirname', shared if identical meshes
+    //! are already in use. does not hold the lock while reading meshes.
+    std::shared_ptr<const Topology> load_topology(const std::string& dirname);
+
+    //! evict least recently used models that are not in use elsewhere
+    //! until the budget is met, keeping model 'keep'. requires the lock to
+    //! be held.
+    void evict(const std::string& keep);
+
+private:
+
+    //! registered models by name
+    std::map<std::string, Entry> entries_;
+    //! topologies in use, by hash of the mean mesh files
+    std::map<uint64_t, std::weak_ptr<const Topology> > topologies_;
+    //! memory budget in bytes (0 for unlimited)
+    size_t budget_;
+    //! usage counter for LRU eviction
+    uint64_t clock_;
+    //! background loading threads and their results
+    std::vector<std::pair<std::thread, std::shared_future<Loaded> > > threads_;
+    //! protects all members
+    mutable std::mutex mutex_;
+};
+
+//=============================================================================
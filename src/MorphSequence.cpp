@@ -0,0 +1,168 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "MorphSequence.h"
+#include <cassert>
+#include <algorithm>
+
+//== IMPLEMENTATION ============================================================
+
+MorphSequence::
+MorphSequence(const MultilinearModel& mlm)
+    : mlm_(mlm)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+void
+MorphSequence::
+add_keyframe(const Eigen::VectorXd& w_skull,
+             const Eigen::VectorXd& w_fstt,
+             unsigned int n_frames)
+{
+    assert(w_skull.size() == mlm_.dim1());
+    assert(w_fstt.size()  == mlm_.dim2());
+
+    Keyframe key;
+    key.w_skull  = w_skull;
+    key.w_fstt   = w_fstt;
+    key.n_frames = keyframes_.empty() ? 0 : std::max(n_frames, 1u);
+    keyframes_.push_back(key);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+MorphSequence::
+clear()
+{
+    keyframes_.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+unsigned int
+MorphSequence::
+n_frames() const
+{
+    if (keyframes_.empty())
+        return 0;
+
+    unsigned int n = 1;
+    for (auto& key : keyframes_)
+        n += key.n_frames;
+    return n;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+MorphSequence::
+parameters(unsigned int frame,
+           Eigen::VectorXd& w_skull, Eigen::VectorXd& w_fstt) const
+{
+    assert(frame < n_frames());
+
+    for (unsigned int i=1; i<keyframes_.size(); ++i)
+    {
+        const Keyframe& a = keyframes_[i-1];
+        const Keyframe& b = keyframes_[i];
+        if (frame < b.n_frames)
+        {
+            const double t = double(frame) / b.n_frames;
+            w_skull = (1.0-t) * a.w_skull + t * b.w_skull;
+            w_fstt  = (1.0-t) * a.w_fstt  + t * b.w_fstt;
+            return;
+        }
+        frame -= b.n_frames;
+    }
+
+    w_skull = keyframes_.back().w_skull;
+    w_fstt  = keyframes_.back().w_fstt;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+MorphSequence::
+generate(const FrameCallback& callback) const
+{
+    if (keyframes_.empty())
+        return false;
+
+    const unsigned int dim0 = mlm_.dim0();
+    Eigen::VectorXd points(dim0);
+    unsigned int frame = 0;
+
+    // a single keyframe is just one evaluation
+    if (keyframes_.size() == 1)
+    {
+        if (!mlm_.evaluate(points, keyframes_[0].w_skull, keyframes_[0].w_fstt))
+            return false;
+        callback(frame, points);
+        return true;
+    }
+
+    Eigen::MatrixXd w_skull(mlm_.dim1(), 4);
+    Eigen::MatrixXd w_fstt(mlm_.dim2(), 4);
+    Eigen::MatrixXd corners;
+
+    for (unsigned int i=1; i<keyframes_.size(); ++i)
+    {
+        const Keyframe& a = keyframes_[i-1];
+        const Keyframe& b = keyframes_[i];
+
+        // evaluate all pairings of the keyframes' skull and FSTT parameters
+        w_skull << a.w_skull, a.w_skull, b.w_skull, b.w_skull;
+        w_fstt  << a.w_fstt,  b.w_fstt,  a.w_fstt,  b.w_fstt;
+        if (!mlm_.evaluate_batch(corners, w_skull, w_fstt))
+            return false;
+
+        // the model is bilinear in w_skull(t) and w_fstt(t), therefore each
+        // frame is a quadratic blend of the four corner evaluations. the
+        // last segment also emits its end keyframe.
+        const unsigned int n = b.n_frames;
+        const unsigned int n_emit = (i+1 == keyframes_.size()) ? n+1 : n;
+        for (unsigned int f=0; f<n_emit; ++f)
+        {
+            const double t  = double(f) / n;
+            const double aa = (1.0-t) * (1.0-t);
+            const double ab = (1.0-t) * t;
+            const double bb = t * t;
+
+#pragma omp parallel for
+            for (int r=0; r<(int)dim0; ++r)
+            {
+                points(r) = aa * corners(r,0) + ab * (corners(r,1) + corners(r,2)) + bb * corners(r,3);
+            }
+
+            callback(frame++, points);
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+MorphSequence::
+generate(MeshExporter& exporter) const
+{
+    return generate([&exporter](unsigned int frame, const Eigen::VectorXd& points)
+                    {
+                        exporter.enqueue(points, frame);
+                    });
+}
+
+//=============================================================================
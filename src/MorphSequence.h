@@ -0,0 +1,81 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+//== INCLUDES =================================================================
+
+#include <vector>
+#include <functional>
+#include <Eigen/Dense>
+
+#include "MultilinearModel.h"
+#include "MeshExporter.h"
+
+
+//== CLASS DEFINITION =========================================================
+
+//! Morph sequence that linearly interpolates between keyframes of skull and
+//! FSTT parameters. Since the model is linear in each parameter set, the
+//! frames of a segment between two keyframes are combinations of the four
+//! evaluations for the keyframes' skull/FSTT pairings, so the tensor is
+//! contracted once per segment instead of once per frame.
+class MorphSequence
+{
+public:
+
+    //! callback receiving the vertex coordinates of each frame
+    typedef std::function<void(unsigned int frame, const Eigen::VectorXd& points)> FrameCallback;
+
+    //! constructor
+    MorphSequence(const MultilinearModel& mlm);
+
+    //! append a keyframe that is reached \c n_frames frames after the
+    //! previous one (\c n_frames is ignored for the first keyframe)
+    void add_keyframe(const Eigen::VectorXd& w_skull,
+                      const Eigen::VectorXd& w_fstt,
+                      unsigned int n_frames);
+
+    //! remove all keyframes
+    void clear();
+
+    //! total number of frames, including first and last keyframe
+    unsigned int n_frames() const;
+
+    //! interpolated parameters of frame \c frame
+    void parameters(unsigned int frame,
+                    Eigen::VectorXd& w_skull, Eigen::VectorXd& w_fstt) const;
+
+    //! evaluate all frames in order and pass them to \c callback
+    bool generate(const FrameCallback& callback) const;
+
+    //! evaluate all frames in order and queue them for writing
+    bool generate(MeshExporter& exporter) const;
+
+private:
+
+    //! a keyframe of the sequence
+    struct Keyframe
+    {
+        Eigen::VectorXd w_skull;
+        Eigen::VectorXd w_fstt;
+        unsigned int n_frames;
+    };
+
+    //! the multilinear model
+    const MultilinearModel& mlm_;
+
+    //! keyframes
+    std::vector<Keyframe> keyframes_;
+};
+
+//=============================================================================
@@ -12,9 +12,16 @@
 
 #include "MultilinearModel.h"
 #include "utils.h"
+#include "Profiler.h"
 #include <iostream>
 #include <fstream>
+#include <cstring>
 #include <unistd.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 using namespace pmp;
 
@@ -22,6 +29,9 @@ using namespace pmp;
 
 MultilinearModel::
 MultilinearModel()
+    : dim0_(0), dim1_(0), dim2_(0),
+      mean_(std::make_shared<std::vector<double> >()),
+      n_skin_vertices_(0), n_skull_vertices_(0)
 {
 }
 
@@ -31,6 +41,8 @@ bool
 MultilinearModel::
 load_means(const std::string& filenameMeanSkin, const std::string& filenameMeanSkull)
 {
+    ScopedTimer timer("load/means");
+
     // load mean skin
     pmp::SurfaceMesh meshMeanSkin;
     meshMeanSkin.read(filenameMeanSkin.c_str());
@@ -55,51 +67,91 @@ load_means(const std::string& filenameMeanSkin, const std::string& filenameMeanS
 
     // build mean vector from mean skin and mean skull
     const unsigned int dim0 = 3*meshMeanSkin.n_vertices() + 3*meshMeanSkull.n_vertices();
-    mean_ = std::vector<double>(dim0, 0.0);
+    std::shared_ptr<std::vector<double> > mean = std::make_shared<std::vector<double> >(dim0, 0.0);
 
     unsigned int c = 0;
     for (auto v : meshMeanSkin.vertices())
     {
         const pmp::Point currentPoint = meshMeanSkinPoints[v];
-        mean_[3*c + 0] = currentPoint[0];
-        mean_[3*c + 1] = currentPoint[1];
-        mean_[3*c + 2] = currentPoint[2];
+        (*mean)[3*c + 0] = currentPoint[0];
+        (*mean)[3*c + 1] = currentPoint[1];
+        (*mean)[3*c + 2] = currentPoint[2];
         ++c;
     }
 
     for (auto v : meshMeanSkull.vertices())
     {
         const pmp::Point currentPoint = meshMeanSkullPoints[v];
-        mean_[3*c + 0] = currentPoint[0];
-        mean_[3*c + 1] = currentPoint[1];
-        mean_[3*c + 2] = currentPoint[2];
+        (*mean)[3*c + 0] = currentPoint[0];
+        (*mean)[3*c + 1] = currentPoint[1];
+        (*mean)[3*c + 2] = currentPoint[2];
         ++c;
     }
 
+    set_means(mean, meshMeanSkin.n_vertices(), meshMeanSkull.n_vertices());
+
     return true;
 }
 
 //-----------------------------------------------------------------------------
 
+void
+MultilinearModel::
+set_means(const std::shared_ptr<const std::vector<double> >& mean,
+          unsigned int n_skin_vertices, unsigned int n_skull_vertices)
+{
+    assert(mean && mean->size() == 3*(n_skin_vertices + n_skull_vertices));
+
+    mean_             = mean;
+    n_skin_vertices_  = n_skin_vertices;
+    n_skull_vertices_ = n_skull_vertices;
+}
+
+//-----------------------------------------------------------------------------
+
+size_t
+MultilinearModel::
+memory_usage() const
+{
+    const size_t n_entries = size_t(dim0_)*dim1_*dim2_;
+    return sizeof(double) * (n_entries +
+                             U_skull_.size() + U_fstt_.size() +
+                             eigenvalues_skull_.size() + eigenvalues_fstt_.size());
+}
+
+//-----------------------------------------------------------------------------
+
 bool
 MultilinearModel::
-load(const std::string& dirname)
+load(const std::string& dirname, bool memory_map)
 {
+    ScopedTimer timer("load/total");
+
     // load the multilinear model tensor
-    std::string filename = dirname + "mlm_tensor.tensor";
-    std::ifstream ifs(filename, std::ofstream::binary);
-    if (!ifs)
+    if (memory_map)
     {
-        std::cerr << "Cannot load tensor\n";
-        return false;
+        if (!load_tensor_mapped(dirname + "mlm_tensor.tensor"))
+            return false;
+    }
+    else
+    {
+        ScopedTimer tensor_timer("load/tensor");
+        std::string filename = dirname + "mlm_tensor.tensor";
+        std::ifstream ifs(filename, std::ofstream::binary);
+        if (!ifs)
+        {
+            std::cerr << "Cannot load tensor\n";
+            return false;
+        }
+        ifs.read(reinterpret_cast<char *>(&dim0_), sizeof(dim0_));
+        ifs.read(reinterpret_cast<char *>(&dim1_), sizeof(dim1_));
+        ifs.read(reinterpret_cast<char *>(&dim2_), sizeof(dim2_));
+        assert(dim0_ && dim1_ && dim2_);
+        mapping_.reset();
+        tensor_.resize(size_t(dim0_)*dim1_*dim2_);
+        ifs.read(reinterpret_cast<char *>(&tensor_[0]), tensor_.size()*sizeof(double));
+        ifs.close();
     }
-    ifs.read(reinterpret_cast<char *>(&dim0_), sizeof(dim0_));
-    ifs.read(reinterpret_cast<char *>(&dim1_), sizeof(dim1_));
-    ifs.read(reinterpret_cast<char *>(&dim2_), sizeof(dim2_));
-    assert(dim0_ && dim1_ && dim2_);
-    tensor_.resize(dim0_*dim1_*dim2_);
-    ifs.read(reinterpret_cast<char *>(&tensor_[0]), dim0_*dim1_*dim2_*sizeof(double));
-    ifs.close();
 
 
     // load matrix U_skull_ from file
@@ -137,75 +189,383 @@ load(const std::string& dirname)
 
 //-----------------------------------------------------------------------------
 
+bool
+MultilinearModel::
+load_tensor_mapped(const std::string& filename)
+{
+#ifdef _WIN32
+    std::cerr << "[ERROR] in 'MultilinearModel::load_tensor_mapped(...)' - Memory mapping is not supported on this platform" << std::endl;
+    return false;
+#else
+    ScopedTimer timer("load/tensor_mapped");
+
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "Cannot load tensor\n";
+        return false;
+    }
+
+    struct stat st;
+    const size_t header = 3*sizeof(unsigned int);
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < header)
+    {
+        std::cerr << "Cannot load tensor\n";
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        std::cerr << "Cannot map tensor\n";
+        return false;
+    }
+
+    // the mapping lives as long as the model (or a copy of it)
+    const size_t length = st.st_size;
+    std::shared_ptr<const char> mapping(static_cast<const char*>(data),
+                                        [length](const char* p) { munmap((void*)p, length); });
+
+    unsigned int dims[3];
+    std::memcpy(dims, mapping.get(), header);
+    const size_t n = size_t(dims[0])*dims[1]*dims[2];
+    if (!n || length < header + n*sizeof(double))
+    {
+        std::cerr << "Tensor file " << filename << " is truncated\n";
+        return false;
+    }
+
+    // entries are read in place (see tensor_at())
+    dim0_ = dims[0];
+    dim1_ = dims[1];
+    dim2_ = dims[2];
+    mapping_ = mapping;
+    std::vector<double>().swap(tensor_);
+    return true;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
 bool
 MultilinearModel::
 evaluate(SurfaceMesh& skin, 
          SurfaceMesh& skull,
          const Eigen::VectorXd& w_skull, 
          const Eigen::VectorXd& w_fstt) const
+{
+    assert(skin.n_vertices()  == n_skin_vertices_);
+    assert(skull.n_vertices() == n_skull_vertices_);
+
+    Eigen::VectorXd points;
+    if (!evaluate(points, w_skull, w_fstt))
+        return false;
+
+    points_to_meshes(points, skin, skull);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+MultilinearModel::
+points_to_meshes(const Eigen::VectorXd& points,
+                 SurfaceMesh& skin,
+                 SurfaceMesh& skull) const
+{
+    ScopedTimer timer("evaluate/copy");
+
+    assert(points.size() == dim0_);
+    assert(skin.n_vertices()  == n_skin_vertices_);
+    assert(skull.n_vertices() == n_skull_vertices_);
+
+
+    // update skin mesh
+    auto skin_points = skin.vertex_property<Point>("v:point");
+    unsigned int c = 0;
+    for (auto v : skin.vertices())
+    {
+        skin_points[v][0] = points(3*c + 0);
+        skin_points[v][1] = points(3*c + 1);
+        skin_points[v][2] = points(3*c + 2);
+        ++c;
+    }
+
+
+    // update skull mesh
+    auto skull_points = skull.vertex_property<pmp::Point>("v:point");
+    for (auto v : skull.vertices())
+    {
+        skull_points[v][0] = points(3*c + 0);
+        skull_points[v][1] = points(3*c + 1);
+        skull_points[v][2] = points(3*c + 2);
+        ++c;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+MultilinearModel::
+evaluate(Eigen::VectorXd& points,
+         const Eigen::VectorXd& w_skull, 
+         const Eigen::VectorXd& w_fstt) const
 {
     // check dimensions
-    assert(mean_.size());
+    assert(mean_->size());
     assert(dim0_ && dim1_ && dim2_);
     assert(w_skull.size() == dim1_);
     assert(w_fstt.size()  == dim2_);
-    assert(3*skin.n_vertices() + 3*skull.n_vertices() == dim0_);
+    assert(mean_->size() == dim0_);
+
+
+    // eliminate mode-1 for 'skull', then mode-2 for 'fstt'
+    Eigen::MatrixXd tempMatrix;
+    contract_skull(tempMatrix, w_skull);
+    evaluate_contracted(points, tempMatrix, w_fstt);
+
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+MultilinearModel::
+evaluate_batch(Eigen::MatrixXd& points,
+               const Eigen::MatrixXd& w_skull,
+               const Eigen::MatrixXd& w_fstt) const
+{
+    ScopedTimer timer("evaluate/batch");
+
+    // check dimensions
+    assert(mean_->size() == dim0_);
+    assert(dim0_ && dim1_ && dim2_);
+    assert(w_skull.rows() == dim1_);
+    assert(w_fstt.rows()  == dim2_);
+    assert(w_skull.cols() == w_fstt.cols());
+
+    const int n_samples = w_skull.cols();
+    const std::vector<double>& mean = *mean_;
+    points.resize(dim0_, n_samples);
+
+
+    // contract each (dim1 x dim2) slice of the tensor with all parameter
+    // sets while it is in cache
+    const char* data = tensor_data();
+#pragma omp parallel for
+    for (int i=0; i<(int)dim0_; ++i)
+    {
+        const size_t slice = size_t(i)*dim1_*dim2_;
+        for (int s=0; s<n_samples; ++s)
+        {
+            double c(0.0);
+            for (unsigned int j=0; j<dim1_; ++j)
+            {
+                double d(0.0);
+                for (unsigned int k=0; k<dim2_; ++k)
+                    d += tensor_at(data, slice + j*dim2_ + k) * w_fstt(k,s);
+                c += d * w_skull(j,s);
+            }
+            points(i,s) = mean[i] + c;
+        }
+    }
+
+
+    return true;
+}
 
+//-----------------------------------------------------------------------------
 
-    unsigned int i,j,k;
+void
+MultilinearModel::
+contract_skull(Eigen::MatrixXd& contracted,
+               const Eigen::VectorXd& w_skull) const
+{
+    ScopedTimer timer("evaluate/mode1");
 
+    assert(dim0_ && dim1_ && dim2_);
+    assert(w_skull.size() == dim1_);
 
     // apply w_skull onto multilinear model, i.e., eliminate mode-1 for 'skull'
-    Eigen::MatrixXd tempMatrix(dim0_, dim2_);
+    // (loop counters are declared inside the loops to keep them thread-private)
+    contracted.resize(dim0_, dim2_);
+    const char* data = tensor_data();
 #pragma omp parallel for
-    for (i=0; i<dim0_; ++i)
+    for (int i=0; i<(int)dim0_; ++i)
     {
-        for (k=0; k<dim2_; ++k)
+        const size_t slice = size_t(i)*dim1_*dim2_;
+        for (unsigned int k=0; k<dim2_; ++k)
         {
             double c(0.0);
-            for (j=0; j<dim1_; ++j)
-                c += tensor(i,j,k) * w_skull(j);
-            tempMatrix(i,k) = c;
+            for (unsigned int j=0; j<dim1_; ++j)
+                c += tensor_at(data, slice + j*dim2_ + k) * w_skull(j);
+            contracted(i,k) = c;
         }
     }
+}
+
+//-----------------------------------------------------------------------------
+
+void
+MultilinearModel::
+evaluate_contracted(Eigen::VectorXd& points,
+                    const Eigen::MatrixXd& contracted,
+                    const Eigen::VectorXd& w_fstt) const
+{
+    ScopedTimer timer("evaluate/mode2");
 
+    assert(mean_->size() == dim0_);
+    assert(contracted.rows() == dim0_ && contracted.cols() == dim2_);
+    assert(w_fstt.size() == dim2_);
 
-    // apply w_fstt onto previously contracted tensor, i.e., eliminate mode-2 for 'fstt'
-    Eigen::VectorXd tempVector(dim0_);
+    // apply w_fstt onto previously contracted tensor, i.e., eliminate mode-2
+    // for 'fstt', and add the mean
+    const std::vector<double>& mean = *mean_;
+    points.resize(dim0_);
 #pragma omp parallel for
-    for (i=0; i<dim0_; ++i)
+    for (int i=0; i<(int)dim0_; ++i)
     {
         double c(0.0);
-        for (k=0; k<dim2_; ++k)
-            c += tempMatrix(i,k) * w_fstt(k);
-        tempVector(i) = c;
+        for (unsigned int k=0; k<dim2_; ++k)
+            c += contracted(i,k) * w_fstt(k);
+        points(i) = mean[i] + c;
     }
+}
 
+//-----------------------------------------------------------------------------
 
-    // update skin mesh
-    auto skin_points = skin.vertex_property<Point>("v:point");
-    unsigned int c = 0;
-    for (auto v : skin.vertices())
+void
+MultilinearModel::
+evaluate_rows(Eigen::VectorXd& points,
+              const std::vector<unsigned int>& rows,
+              const Eigen::VectorXd& w_skull,
+              const Eigen::VectorXd& w_fstt) const
+{
+    ScopedTimer timer("evaluate/rows");
+
+    assert(mean_->size() == dim0_);
+    assert(w_skull.size() == dim1_);
+    assert(w_fstt.size()  == dim2_);
+
+    const std::vector<double>& mean = *mean_;
+    const char* data = tensor_data();
+    points.resize(rows.size());
+#pragma omp parallel for
+    for (int r=0; r<(int)rows.size(); ++r)
     {
-        skin_points[v][0] = mean_[3*c + 0] + tempVector(3*c + 0);
-        skin_points[v][1] = mean_[3*c + 1] + tempVector(3*c + 1);
-        skin_points[v][2] = mean_[3*c + 2] + tempVector(3*c + 2);
-        ++c;
+        const unsigned int i = rows[r];
+        assert(i < dim0_);
+
+        const size_t slice = size_t(i)*dim1_*dim2_;
+        double c(0.0);
+        for (unsigned int j=0; j<dim1_; ++j)
+        {
+            double d(0.0);
+            for (unsigned int k=0; k<dim2_; ++k)
+                d += tensor_at(data, slice + j*dim2_ + k) * w_fstt(k);
+            c += d * w_skull(j);
+        }
+        points(r) = mean[i] + c;
     }
+}
 
+//-----------------------------------------------------------------------------
 
-    // update skull mesh
-    auto skull_points = skull.vertex_property<pmp::Point>("v:point");
-    for (auto v : skull.vertices())
+void
+MultilinearModel::
+jacobian(Eigen::MatrixXd& jacobian,
+         const std::vector<unsigned int>& vertices,
+         const Eigen::VectorXd& w_skull,
+         const Eigen::VectorXd& w_fstt) const
+{
+    ScopedTimer timer("evaluate/jacobian");
+
+    assert(w_skull.size() == dim1_);
+    assert(w_fstt.size()  == dim2_);
+
+    // column-major storage of the Eigen matrix
+    jacobian.resize(3*vertices.size(), dim1_+dim2_);
+    jacobian_into(jacobian.data(), vertices.data(), vertices.size(),
+                  w_skull.data(), w_fstt.data(), 1, jacobian.rows());
+}
+
+//-----------------------------------------------------------------------------
+
+void
+MultilinearModel::
+jacobian_into(double* jacobian,
+              const unsigned int* vertices, unsigned int n_vertices,
+              const double* w_skull, const double* w_fstt,
+              size_t row_stride, size_t col_stride) const
+{
+    assert(dim0_ && dim1_ && dim2_);
+
+    // d/dwSkull(j) = sum_k T(i,j,k) wFstt(k), d/dwFstt(k) = sum_j T(i,j,k) wSkull(j)
+    const char* data = tensor_data();
+    for (unsigned int r=0; r<3*n_vertices; ++r)
     {
-        skull_points[v][0] = mean_[3*c + 0] + tempVector(3*c + 0);
-        skull_points[v][1] = mean_[3*c + 1] + tempVector(3*c + 1);
-        skull_points[v][2] = mean_[3*c + 2] + tempVector(3*c + 2);
-        ++c;
+        const unsigned int i = 3*vertices[r/3] + r%3;
+        assert(i < dim0_);
+
+        double* row = jacobian + r*row_stride;
+        for (unsigned int c=0; c<dim1_+dim2_; ++c)
+            row[c*col_stride] = 0.0;
+
+        for (unsigned int j=0; j<dim1_; ++j)
+        {
+            for (unsigned int k=0; k<dim2_; ++k)
+            {
+                const double t = tensor_at(data, size_t(i)*dim1_*dim2_ + j*dim2_ + k);
+                row[j*col_stride]         += t * w_fstt[k];
+                row[(dim1_+k)*col_stride] += t * w_skull[j];
+            }
+        }
     }
+}
 
+//-----------------------------------------------------------------------------
 
-    return true;
+template <typename Scalar>
+void
+MultilinearModel::
+evaluate_into(Scalar* points,
+              const double* w_skull, const double* w_fstt,
+              unsigned int n_samples) const
+{
+    assert(mean_->size() == dim0_);
+    assert(dim0_ && dim1_ && dim2_);
+
+    // both modes are contracted per tensor slice, such that no temporary
+    // storage is needed
+    const std::vector<double>& mean = *mean_;
+    const char* data = tensor_data();
+#pragma omp parallel for
+    for (int i=0; i<(int)dim0_; ++i)
+    {
+        const size_t slice = size_t(i)*dim1_*dim2_;
+        for (unsigned int s=0; s<n_samples; ++s)
+        {
+            const double* ws = w_skull + size_t(s)*dim1_;
+            const double* wf = w_fstt  + size_t(s)*dim2_;
+            double c(0.0);
+            for (unsigned int j=0; j<dim1_; ++j)
+            {
+                double d(0.0);
+                for (unsigned int k=0; k<dim2_; ++k)
+                    d += tensor_at(data, slice + j*dim2_ + k) * wf[k];
+                c += d * ws[j];
+            }
+            points[size_t(s)*dim0_ + i] = Scalar(mean[i] + c);
+        }
+    }
 }
 
+// instantiate for single and double precision output
+template void MultilinearModel::evaluate_into<float>(float*, const double*, const double*, unsigned int) const;
+template void MultilinearModel::evaluate_into<double>(double*, const double*, const double*, unsigned int) const;
+
 //=============================================================================
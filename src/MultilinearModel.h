@@ -16,6 +16,8 @@
 
 #include <vector>
 #include <string>
+#include <memory>
+#include <cstring>
 #include <Eigen/Dense>
 #include <pmp/SurfaceMesh.h>
 
@@ -35,15 +37,77 @@ public:
     bool load_means(const std::string& filenameMeanSkin, 
                     const std::string& filenameMeanSkull);
 
+    //! use mean skin and skull geometry shared with other models of the same
+    //! topology ('mean' holds skin coordinates followed by skull coordinates)
+    void set_means(const std::shared_ptr<const std::vector<double> >& mean,
+                   unsigned int n_skin_vertices, unsigned int n_skull_vertices);
+
     //! load multilinear model: multilinear model tensor, matrix U_skull,
-    //! matrix U_fstt, eigenvalues_skull, and eigenvalues_fstt
-    bool load(const std::string& dirname);
+    //! matrix U_fstt, eigenvalues_skull, and eigenvalues_fstt. if
+    //! 'memory_map' is set, the tensor is not read but evaluated directly
+    //! from a read-only memory mapping of its file, whose pages are loaded
+    //! on demand and shared with other processes using the same file.
+    bool load(const std::string& dirname, bool memory_map = false);
 
     //! evaluate multilinear model, i.e., for given parameters 'wSkull'
     //! and 'wFstt', compute new skin/skull meshes
     bool evaluate(pmp::SurfaceMesh& meshSkin, pmp::SurfaceMesh& meshSkull,
                   const Eigen::VectorXd& wSkull, const Eigen::VectorXd& wFstt) const;
 
+    //! evaluate multilinear model into a flat vector of vertex coordinates
+    //! (x,y,z of all skin vertices followed by all skull vertices)
+    bool evaluate(Eigen::VectorXd& points,
+                  const Eigen::VectorXd& wSkull, const Eigen::VectorXd& wFstt) const;
+
+    //! evaluate multilinear model for several parameter sets at once. column s
+    //! of 'wSkull' and 'wFstt' holds the parameters of sample s, column s of
+    //! 'points' receives its vertex coordinates. the tensor is streamed only
+    //! once for all samples.
+    bool evaluate_batch(Eigen::MatrixXd& points,
+                        const Eigen::MatrixXd& wSkull, const Eigen::MatrixXd& wFstt) const;
+
+    //! apply 'wSkull' onto the tensor, i.e., eliminate mode-1. the resulting
+    //! (dim0 x dim2) matrix can be re-used for evaluations with different
+    //! FSTT parameters by evaluate_contracted().
+    void contract_skull(Eigen::MatrixXd& contracted, const Eigen::VectorXd& wSkull) const;
+
+    //! evaluate multilinear model from a skull-contracted tensor (see
+    //! contract_skull()) and FSTT parameters 'wFstt'
+    void evaluate_contracted(Eigen::VectorXd& points,
+                             const Eigen::MatrixXd& contracted, const Eigen::VectorXd& wFstt) const;
+
+    //! evaluate only the given rows of mode-0 (i.e., coordinates 3*v+d of
+    //! vertex v, skin vertices first), such that the cost is proportional to
+    //! the number of rows. 'points' receives one value per row.
+    void evaluate_rows(Eigen::VectorXd& points, const std::vector<unsigned int>& rows,
+                       const Eigen::VectorXd& wSkull, const Eigen::VectorXd& wFstt) const;
+
+    //! evaluate 'n_samples' parameter sets into a caller-provided buffer
+    //! without allocating memory. 'wSkull' and 'wFstt' hold dim1 and dim2
+    //! parameters per sample, 'points' receives dim0 coordinates per sample
+    //! (Scalar is float or double).
+    template <typename Scalar>
+    void evaluate_into(Scalar* points, const double* wSkull, const double* wFstt,
+                       unsigned int n_samples = 1) const;
+
+    //! copy a flat vector of vertex coordinates (as computed by evaluate())
+    //! into the skin and skull meshes
+    void points_to_meshes(const Eigen::VectorXd& points,
+                          pmp::SurfaceMesh& meshSkin, pmp::SurfaceMesh& meshSkull) const;
+
+    //! compute the Jacobian of the coordinates of the given vertices w.r.t.
+    //! the parameters. 'vertices' index skin vertices first, followed by
+    //! skull vertices. 'jacobian' is a (3*#vertices x dim1+dim2) matrix,
+    //! whose first dim1 columns belong to 'wSkull'.
+    void jacobian(Eigen::MatrixXd& jacobian, const std::vector<unsigned int>& vertices,
+                  const Eigen::VectorXd& wSkull, const Eigen::VectorXd& wFstt) const;
+
+    //! compute the Jacobian (see above) into a caller-provided buffer without
+    //! allocating memory. entry (r,c) is stored at r*rowStride + c*colStride.
+    void jacobian_into(double* jacobian, const unsigned int* vertices, unsigned int nVertices,
+                       const double* wSkull, const double* wFstt,
+                       size_t rowStride, size_t colStride) const;
+
 public:
 
     //! get dimension 0
@@ -53,6 +117,36 @@ public:
     //! get dimension 2
     unsigned int dim2() const { return dim2_; }
 
+    //! get tensor entry (i0,i1,i2)
+    double tensor_entry(unsigned int i0, unsigned int i1, unsigned int i2) const
+    {
+        return tensor(i0, i1, i2);
+    }
+
+    //! get number of skin vertices
+    unsigned int n_skin_vertices() const { return n_skin_vertices_; }
+    //! get number of skull vertices
+    unsigned int n_skull_vertices() const { return n_skull_vertices_; }
+
+
+    //! get mean skin and skull vertex coordinates
+    const std::vector<double>& mean() const
+    {
+        return *mean_;
+    }
+
+    //! get shared mean skin and skull vertex coordinates
+    const std::shared_ptr<const std::vector<double> >& shared_mean() const
+    {
+        return mean_;
+    }
+
+    //! memory used by tensor, mode matrices, and eigenvalues in bytes
+    //! (the possibly shared mean is not included, a memory-mapped tensor is)
+    size_t memory_usage() const;
+
+    //! is the tensor evaluated from a memory mapping?
+    bool is_memory_mapped() const { return bool(mapping_); }
 
     //! get matrix U_skull
     const Eigen::MatrixXd& U_skull() const
@@ -82,14 +176,30 @@ public:
 private: 
 
 
-    //! write access to tensor data
-    double& tensor(unsigned int i0, unsigned int i1, unsigned int i2) {
-        return tensor_[i2 + i1*dim2_ + i0*dim1_*dim2_];
+    //! map the tensor file into memory
+    bool load_tensor_mapped(const std::string& filename);
+
+    //! first byte of the tensor entries, either in tensor_ or in the mapping
+    const char* tensor_data() const
+    {
+        return mapping_ ? mapping_.get() + 3*sizeof(unsigned int)
+                        : reinterpret_cast<const char*>(tensor_.data());
+    }
+
+    //! read entry 'index' of the tensor entries starting at 'data'. the
+    //! entries of a mapped tensor file are not aligned for doubles (they
+    //! follow a 12 byte header), hence they are read by memcpy, which
+    //! compiles to a plain (unaligned) load.
+    static double tensor_at(const char* data, size_t index)
+    {
+        double t;
+        std::memcpy(&t, data + index*sizeof(double), sizeof(double));
+        return t;
     }
 
     //! read access to tensor data
     double tensor(unsigned int i0, unsigned int i1, unsigned int i2) const {
-        return tensor_[i2 + i1*dim2_ + i0*dim1_*dim2_];
+        return tensor_at(tensor_data(), i2 + i1*dim2_ + size_t(i0)*dim1_*dim2_);
     }
 
 
@@ -100,6 +210,8 @@ private:
     //! 1-mode: different skulls
     //! 2-mode: different FSTTs each
     std::vector<double> tensor_;
+    //! read-only mapping of the tensor file, used instead of tensor_ if set
+    std::shared_ptr<const char> mapping_;
 
     //! tensor dimensions
     unsigned int dim0_, dim1_, dim2_;
@@ -114,8 +226,11 @@ private:
     //! eigenvalues w.r.t. FSTT
     Eigen::VectorXd eigenvalues_fstt_;
 
-    //! mean skin surface and skull
-    std::vector< double > mean_;
+    //! mean skin surface and skull, may be shared between models
+    std::shared_ptr<const std::vector<double> > mean_;
+
+    //! number of skin and skull vertices (splitting mode-0)
+    unsigned int n_skin_vertices_, n_skull_vertices_;
 };
 
 //=============================================================================
@@ -0,0 +1,120 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "PenetrationChecker.h"
+#include "Profiler.h"
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+
+using namespace pmp;
+
+//== IMPLEMENTATION ============================================================
+
+PenetrationChecker::
+PenetrationChecker()
+    : n_skin_vertices_(0), n_skull_vertices_(0), threshold_(1.0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+PenetrationChecker::
+set_topology(const SurfaceMesh& skin, const SurfaceMesh& skull)
+{
+    std::vector<unsigned int> triangles;
+    triangles.reserve(3*skull.n_faces());
+    for (auto f : skull.faces())
+    {
+        unsigned int n = 0;
+        for (auto v : skull.vertices(f))
+        {
+            triangles.push_back(v.idx());
+            ++n;
+        }
+        if (n != 3)
+        {
+            std::cerr << "[ERROR] in 'PenetrationChecker::set_topology(...)' - Skull has to be a triangle mesh" << std::endl;
+            return false;
+        }
+    }
+
+    std::vector<double> points;
+    points.reserve(3*skull.n_vertices());
+    for (auto v : skull.vertices())
+    {
+        const Point& p = skull.position(v);
+        points.push_back(p[0]);
+        points.push_back(p[1]);
+        points.push_back(p[2]);
+    }
+
+    n_skin_vertices_  = skin.n_vertices();
+    n_skull_vertices_ = skull.n_vertices();
+    bvh_.build(triangles, points.data(), n_skull_vertices_);
+    hints_.assign(n_skin_vertices_, -1);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+PenetrationChecker::Report
+PenetrationChecker::
+check(const Eigen::VectorXd& points, Eigen::VectorXd* distances)
+{
+    ScopedTimer timer("validate/check");
+
+    assert(points.size() == 3*(n_skin_vertices_ + n_skull_vertices_));
+
+    bvh_.refit(points.data() + 3*n_skin_vertices_);
+
+    if (distances)
+        distances->resize(n_skin_vertices_);
+
+    unsigned int n_inside = 0, n_close = 0;
+    double max_depth = 0.0;
+
+#pragma omp parallel for reduction(+:n_inside,n_close) reduction(max:max_depth)
+    for (int i=0; i<(int)n_skin_vertices_; ++i)
+    {
+        const Eigen::Vector3d p(points(3*i), points(3*i+1), points(3*i+2));
+        const TriangleBVH::Hit hit = bvh_.closest(p, hints_[i]);
+        hints_[i] = hit.triangle;
+
+        if (hit.distance < 0.0)
+        {
+            ++n_inside;
+            max_depth = std::max(max_depth, -hit.distance);
+        }
+        else if (hit.distance < threshold_)
+        {
+            ++n_close;
+        }
+
+        if (distances)
+            (*distances)(i) = hit.distance;
+    }
+
+    Report report;
+    report.n_inside  = n_inside;
+    report.n_close   = n_close;
+    report.max_depth = max_depth;
+    report.score     = n_skin_vertices_ ? double(n_inside + n_close) / n_skin_vertices_ : 0.0;
+
+    Profiler::instance().add_count("validate/inside", n_inside);
+
+    return report;
+}
+
+//=============================================================================
@@ -0,0 +1,71 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+//== INCLUDES =================================================================
+
+#include "TriangleBVH.h"
+#include <vector>
+#include <Eigen/Dense>
+#include <pmp/SurfaceMesh.h>
+
+
+//== CLASS DEFINITION =========================================================
+
+//! Plausibility check for evaluated samples: detects skin vertices that lie
+//! inside the skull or closer to it than a minimum tissue thickness. The
+//! skull BVH is built once for the model topology and refitted per sample,
+//! so checking keeps up with bulk sampling.
+class PenetrationChecker
+{
+public:
+
+    //! result of checking one sample
+    struct Report
+    {
+        unsigned int n_inside;  //!< skin vertices inside the skull
+        unsigned int n_close;   //!< skin vertices outside but closer than the threshold
+        double max_depth;       //!< maximum penetration depth (0 if none)
+        double score;           //!< fraction of skin vertices closer than the threshold
+    };
+
+    //! constructor
+    PenetrationChecker();
+
+    //! set skin and skull topology (triangle meshes)
+    bool set_topology(const pmp::SurfaceMesh& skin, const pmp::SurfaceMesh& skull);
+
+    //! set minimum tissue thickness (in model units, default 1.0)
+    void set_threshold(double threshold) { threshold_ = threshold; }
+
+    //! minimum tissue thickness
+    double threshold() const { return threshold_; }
+
+    //! check a sample given as flat coordinate vector (skin vertices first,
+    //! then skull vertices, as returned by MultilinearModel::evaluate).
+    //! optionally returns the signed skull distance of each skin vertex.
+    Report check(const Eigen::VectorXd& points, Eigen::VectorXd* distances = nullptr);
+
+private:
+
+    //! BVH over the skull
+    TriangleBVH bvh_;
+    //! number of skin and skull vertices
+    unsigned int n_skin_vertices_, n_skull_vertices_;
+    //! minimum tissue thickness
+    double threshold_;
+    //! closest skull triangle of each skin vertex in the previous sample
+    std::vector<int> hints_;
+};
+
+//=============================================================================
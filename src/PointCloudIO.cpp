@@ -0,0 +1,326 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "PointCloudIO.h"
+#include "Profiler.h"
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <cassert>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+//== HELPER ===================================================================
+
+namespace {
+
+//! exactly representable powers of ten
+const double powers_of_ten[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                 1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+//! minimum chunk size for parallel parsing
+const size_t min_chunk_size = 1 << 20;
+
+//-----------------------------------------------------------------------------
+
+inline bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+//-----------------------------------------------------------------------------
+
+//! parse one number starting at \c p and advance \c p behind it. numbers
+//! with at most 19 significant digits and small exponents are converted
+//! exactly by the fast path of Clinger's algorithm, all others by strtod().
+//! the text has to be terminated by a non-numeric character.
+inline bool parse_double(const char*& p, double& value)
+{
+    const char* start = p;
+
+    bool negative = false;
+    if (*p == '-' || *p == '+')
+    {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    uint64_t mantissa = 0;
+    int digits   = 0;     // significant digits in mantissa
+    int exponent = 0;     // decimal exponent of mantissa
+    bool any     = false; // any digit at all?
+    bool exact   = true;  // all digits fit into mantissa?
+
+    for (; is_digit(*p); ++p)
+    {
+        any = true;
+        if (mantissa == 0 && *p == '0') continue;
+        if (digits < 19) { mantissa = 10*mantissa + (*p - '0'); ++digits; }
+        else             { ++exponent; exact = false; }
+    }
+    if (*p == '.')
+    {
+        for (++p; is_digit(*p); ++p)
+        {
+            any = true;
+            if (mantissa == 0 && *p == '0') { --exponent; continue; }
+            if (digits < 19) { mantissa = 10*mantissa + (*p - '0'); ++digits; --exponent; }
+            else             { exact = false; }
+        }
+    }
+    if (any && (*p == 'e' || *p == 'E'))
+    {
+        const char* q = p+1;
+        bool negative_exponent = false;
+        if (*q == '-' || *q == '+')
+        {
+            negative_exponent = (*q == '-');
+            ++q;
+        }
+        if (is_digit(*q))
+        {
+            int e = 0;
+            for (; is_digit(*q); ++q)
+                if (e < 100000) e = 10*e + (*q - '0');
+            exponent += negative_exponent ? -e : e;
+            p = q;
+        }
+    }
+
+    // fast path
+    if (any && exact && mantissa < (uint64_t(1) << 53) &&
+        exponent >= -22 && exponent <= 22)
+    {
+        value = double(mantissa);
+        value = (exponent < 0) ? value / powers_of_ten[-exponent] : value * powers_of_ten[exponent];
+        if (negative) value = -value;
+        return true;
+    }
+
+    // slow path, also handles inf and nan
+    char* end;
+    value = std::strtod(start, &end);
+    if (end == start)
+        return false;
+    p = end;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+//! split text [begin, end) into chunks that start at the beginning of a line
+std::vector<const char*> split_lines(const char* begin, const char* end)
+{
+#ifdef _OPENMP
+    const size_t max_chunks = 4 * omp_get_max_threads();
+#else
+    const size_t max_chunks = 1;
+#endif
+    const size_t size = end - begin;
+    const size_t n_chunks = std::max<size_t>(1, std::min(max_chunks, size / min_chunk_size));
+
+    std::vector<const char*> bounds(1, begin);
+    for (size_t c=1; c<n_chunks; ++c)
+    {
+        const char* p = std::max(bounds.back(), begin + c*size/n_chunks);
+        while (p < end && *p != '\n') ++p;
+        if (p < end) ++p;
+        bounds.push_back(p);
+    }
+    bounds.push_back(end);
+
+    return bounds;
+}
+
+//-----------------------------------------------------------------------------
+
+//! concatenate per-chunk results
+template <typename T>
+void concatenate(const std::vector< std::vector<T> >& chunks, std::vector<T>& result)
+{
+    size_t n = 0;
+    for (auto& c : chunks) n += c.size();
+    result.clear();
+    result.reserve(n);
+    for (auto& c : chunks) result.insert(result.end(), c.begin(), c.end());
+}
+
+} // anonymous namespace
+
+
+//== IMPLEMENTATION ============================================================
+
+bool read_file(const std::string& filename, std::vector<char>& buffer)
+{
+    std::ifstream ifs(filename.c_str(), std::ifstream::binary | std::ifstream::ate);
+    if (!ifs.is_open())
+    {
+        std::cerr << "Cannot read " << filename << std::endl;
+        return false;
+    }
+    const std::streamsize size = ifs.tellg();
+    ifs.seekg(0);
+
+    buffer.resize(size + 1);
+    ifs.read(buffer.data(), size);
+    buffer[size] = 0;
+
+    return !ifs.fail();
+}
+
+//-----------------------------------------------------------------------------
+
+bool parse_numbers(const std::vector<char>& text, std::vector<double>& values)
+{
+    assert(!text.empty() && text.back() == 0);
+    const char* begin = text.data();
+    const char* end   = text.data() + text.size() - 1;
+
+    const std::vector<const char*> bounds = split_lines(begin, end);
+    const int n_chunks = bounds.size() - 1;
+    std::vector< std::vector<double> > chunks(n_chunks);
+    std::vector<char> chunk_ok(n_chunks, true);
+
+#pragma omp parallel for schedule(dynamic)
+    for (int c=0; c<n_chunks; ++c)
+    {
+        std::vector<double>& chunk = chunks[c];
+        chunk.reserve((bounds[c+1] - bounds[c]) / 8);
+
+        const char* p = bounds[c];
+        double value;
+        while (true)
+        {
+            while (p < bounds[c+1] && is_space(*p)) ++p;
+            if (p >= bounds[c+1]) break;
+            if (!parse_double(p, value)) { chunk_ok[c] = false; break; }
+            chunk.push_back(value);
+        }
+    }
+
+    concatenate(chunks, values);
+    return std::find(chunk_ok.begin(), chunk_ok.end(), false) == chunk_ok.end();
+}
+
+//-----------------------------------------------------------------------------
+
+bool read_xyz(const std::string& filename, std::vector<float>& points)
+{
+    ScopedTimer timer("io/read_xyz");
+
+    std::vector<char> text;
+    if (!read_file(filename, text))
+        return false;
+
+    const std::vector<const char*> bounds = split_lines(text.data(), text.data() + text.size() - 1);
+    const int n_chunks = bounds.size() - 1;
+    std::vector< std::vector<float> > chunks(n_chunks);
+    std::vector<char> chunk_ok(n_chunks, true);
+
+#pragma omp parallel for schedule(dynamic)
+    for (int c=0; c<n_chunks; ++c)
+    {
+        std::vector<float>& chunk = chunks[c];
+        chunk.reserve((bounds[c+1] - bounds[c]) / 8);
+
+        const char* p = bounds[c];
+        double value;
+        while (p < bounds[c+1])
+        {
+            // parse the first three numbers of a line, skip the rest
+            unsigned int column = 0;
+            while (p < bounds[c+1] && *p != '\n')
+            {
+                if (is_space(*p)) { ++p; continue; }
+                if (!parse_double(p, value)) { chunk_ok[c] = false; p = bounds[c+1]; break; }
+                if (column < 3) chunk.push_back(float(value));
+                ++column;
+            }
+            if (column != 0 && column < 3)
+            {
+                chunk_ok[c] = false;
+                break;
+            }
+            ++p;
+        }
+    }
+
+    if (std::find(chunk_ok.begin(), chunk_ok.end(), false) != chunk_ok.end())
+    {
+        std::cerr << "Cannot parse points in " << filename << std::endl;
+        return false;
+    }
+
+    concatenate(chunks, points);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool read_binary_points(const std::string& filename, std::vector<float>& points)
+{
+    ScopedTimer timer("io/read_binary_points");
+
+    std::ifstream ifs(filename.c_str(), std::ifstream::binary);
+    if (!ifs.is_open())
+    {
+        std::cerr << "Cannot read " << filename << std::endl;
+        return false;
+    }
+    unsigned int n_points = 0;
+    ifs.read(reinterpret_cast<char *>(&n_points), sizeof(n_points));
+    points.resize(3*size_t(n_points));
+    ifs.read(reinterpret_cast<char *>(points.data()), points.size()*sizeof(float));
+
+    return !ifs.fail();
+}
+
+//-----------------------------------------------------------------------------
+
+bool write_binary_points(const std::string& filename, const std::vector<float>& points)
+{
+    std::ofstream ofs(filename.c_str(), std::ofstream::binary);
+    if (!ofs.is_open())
+    {
+        std::cerr << "Cannot write " << filename << std::endl;
+        return false;
+    }
+    const unsigned int n_points = points.size() / 3;
+    ofs.write(reinterpret_cast<const char *>(&n_points), sizeof(n_points));
+    ofs.write(reinterpret_cast<const char *>(points.data()), 3*size_t(n_points)*sizeof(float));
+    ofs.close();
+
+    return !ofs.fail();
+}
+
+//-----------------------------------------------------------------------------
+
+bool read_points(const std::string& filename, std::vector<float>& points)
+{
+    const std::string ext = ".bxyz";
+    if (filename.size() >= ext.size() &&
+        filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0)
+        return read_binary_points(filename, points);
+
+    return read_xyz(filename, points);
+}
+
+//=============================================================================
@@ -0,0 +1,44 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+//== INCLUDES =================================================================
+
+#include <vector>
+#include <string>
+
+
+//== FUNCTION DEFINITIONS =====================================================
+
+//! read a whole file into \c buffer, followed by a terminating zero
+bool read_file(const std::string& filename, std::vector<char>& buffer);
+
+//! parse all whitespace-separated numbers of a zero-terminated text. the text
+//! is split into chunks at line breaks, which are parsed in parallel.
+bool parse_numbers(const std::vector<char>& text, std::vector<double>& values);
+
+//! read point set from text file with one point per line ("x y z", further
+//! columns like normals are skipped) into a contiguous array x0,y0,z0,x1,...
+bool read_xyz(const std::string& filename, std::vector<float>& points);
+
+//! read point set from binary file: uint32 number of points followed by
+//! float32 x,y,z of each point
+bool read_binary_points(const std::string& filename, std::vector<float>& points);
+
+//! write point set to binary file (see read_binary_points())
+bool write_binary_points(const std::string& filename, const std::vector<float>& points);
+
+//! read point set from binary (.bxyz) or text (any other extension) file
+bool read_points(const std::string& filename, std::vector<float>& points);
+
+//=============================================================================
@@ -0,0 +1,221 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "Profiler.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+//== IMPLEMENTATION ============================================================
+
+const unsigned int Profiler::n_recent;
+const unsigned int Profiler::n_buckets;
+
+//-----------------------------------------------------------------------------
+
+Profiler::Stage::
+Stage()
+    : count(0), total(0.0), last(0.0), min(DBL_MAX), max(0.0),
+      next(0), histogram(n_buckets, 0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+double
+Profiler::Stage::
+percentile(double p) const
+{
+    if (recent.empty())
+        return 0.0;
+
+    std::vector<float> t = recent;
+    const unsigned int i = std::min<unsigned int>(t.size()-1, (unsigned int)(p / 100.0 * t.size()));
+    std::nth_element(t.begin(), t.begin()+i, t.end());
+    return t[i];
+}
+
+//-----------------------------------------------------------------------------
+
+std::vector<float>
+Profiler::Stage::
+recent_ms() const
+{
+    std::vector<float> ms;
+    ms.reserve(recent.size());
+    const unsigned int first = (recent.size() < n_recent) ? 0 : next;
+    for (unsigned int i=0; i<recent.size(); ++i)
+        ms.push_back(1000.0f * recent[(first + i) % recent.size()]);
+    return ms;
+}
+
+//-----------------------------------------------------------------------------
+
+Profiler::
+Profiler()
+    : enabled_(true)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+Profiler&
+Profiler::
+instance()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+Profiler::
+add_time(const std::string& name, double seconds)
+{
+    if (!enabled_)
+        return;
+
+    // power-of-two bucket of the timing in microseconds
+    const double us = seconds * 1e6;
+    unsigned int bucket = (us < 1.0) ? 0 : 1 + (unsigned int)std::log2(us);
+    bucket = std::min(bucket, n_buckets-1);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Stage& stage = stages_[name];
+    if (stage.name.empty())
+        stage.name = name;
+
+    stage.count += 1;
+    stage.total += seconds;
+    stage.last   = seconds;
+    stage.min    = std::min(stage.min, seconds);
+    stage.max    = std::max(stage.max, seconds);
+    stage.histogram[bucket] += 1;
+
+    if (stage.recent.size() < n_recent)
+    {
+        stage.recent.push_back(seconds);
+    }
+    else
+    {
+        stage.recent[stage.next] = seconds;
+        stage.next = (stage.next + 1) % n_recent;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void
+Profiler::
+add_count(const std::string& name, unsigned long n)
+{
+    if (!enabled_)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    counters_[name] += n;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+Profiler::
+clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    stages_.clear();
+    counters_.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+std::vector<Profiler::Stage>
+Profiler::
+stages() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Stage> stages;
+    for (auto& s : stages_)
+        stages.push_back(s.second);
+    return stages;
+}
+
+//-----------------------------------------------------------------------------
+
+std::map<std::string, unsigned long>
+Profiler::
+counters() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return counters_;
+}
+
+//-----------------------------------------------------------------------------
+
+std::string
+Profiler::
+to_json() const
+{
+    const std::vector<Stage> all_stages = stages();
+    const std::map<std::string, unsigned long> all_counters = counters();
+
+    std::ostringstream s;
+    s << "{\n  \"stages\": [\n";
+    for (unsigned int i=0; i<all_stages.size(); ++i)
+    {
+        const Stage& stage = all_stages[i];
+        s << "    {\"name\": \"" << stage.name << "\""
+          << ", \"count\": " << stage.count
+          << ", \"total_s\": " << stage.total
+          << ", \"mean_s\": " << stage.mean()
+          << ", \"min_s\": " << stage.min
+          << ", \"max_s\": " << stage.max
+          << ", \"last_s\": " << stage.last
+          << ", \"p50_s\": " << stage.percentile(50.0)
+          << ", \"p95_s\": " << stage.percentile(95.0)
+          << ", \"histogram_log2_us\": [";
+        for (unsigned int b=0; b<n_buckets; ++b)
+            s << (b ? ", " : "") << stage.histogram[b];
+        s << "]}" << (i+1 < all_stages.size() ? "," : "") << "\n";
+    }
+    s << "  ],\n  \"counters\": {";
+    unsigned int i = 0;
+    for (auto& c : all_counters)
+        s << (i++ ? ", " : "") << "\"" << c.first << "\": " << c.second;
+    s << "}\n}\n";
+
+    return s.str();
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+Profiler::
+write_json(const std::string& filename) const
+{
+    std::ofstream ofs(filename);
+    if (!ofs.is_open())
+    {
+        std::cerr << "Cannot write profile " << filename << std::endl;
+        return false;
+    }
+    ofs << to_json();
+    ofs.close();
+    return !ofs.fail();
+}
+
+//=============================================================================
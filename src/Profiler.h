@@ -0,0 +1,137 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+//== INCLUDES =================================================================
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <chrono>
+
+
+//== CLASS DEFINITION =========================================================
+
+//! Collects timings of named stages (e.g. "evaluate/mode1") and named event
+//! counters. For each stage it keeps summary statistics, the most recent
+//! timings, and a histogram over all timings with power-of-two buckets.
+//! All functions are thread-safe.
+class Profiler
+{
+public:
+
+    //! number of recent timings kept per stage
+    static const unsigned int n_recent = 128;
+    //! number of histogram buckets: [0,1us), [1us,2us), [2us,4us), ...
+    static const unsigned int n_buckets = 28;
+
+    //! statistics of one stage
+    struct Stage
+    {
+        Stage();
+
+        //! mean time in seconds
+        double mean() const { return count ? total / count : 0.0; }
+
+        //! percentile (0..100) of the recent timings in seconds
+        double percentile(double p) const;
+
+        //! recent timings in milliseconds, oldest first
+        std::vector<float> recent_ms() const;
+
+        std::string name;
+        unsigned long count;
+        double total, last, min, max;
+        std::vector<float> recent;           //!< ring buffer of timings (seconds)
+        unsigned int next;                   //!< next slot in ring buffer
+        std::vector<unsigned long> histogram; //!< counts per power-of-two bucket
+    };
+
+    //! the global profiler
+    static Profiler& instance();
+
+    //! enable or disable recording
+    void set_enabled(bool enabled) { enabled_ = enabled; }
+
+    //! is recording enabled?
+    bool enabled() const { return enabled_; }
+
+    //! record a timing for stage \c name
+    void add_time(const std::string& name, double seconds);
+
+    //! increment counter \c name by \c n
+    void add_count(const std::string& name, unsigned long n = 1);
+
+    //! remove all stages and counters
+    void clear();
+
+    //! copy of all stages, sorted by name
+    std::vector<Stage> stages() const;
+
+    //! copy of all counters, sorted by name
+    std::map<std::string, unsigned long> counters() const;
+
+    //! all statistics as JSON document
+    std::string to_json() const;
+
+    //! write JSON document to file
+    bool write_json(const std::string& filename) const;
+
+private:
+
+    Profiler();
+
+    //! recording enabled?
+    std::atomic<bool> enabled_;
+    //! stage statistics
+    std::map<std::string, Stage> stages_;
+    //! event counters
+    std::map<std::string, unsigned long> counters_;
+    //! protects stages and counters
+    mutable std::mutex mutex_;
+};
+
+
+//== CLASS DEFINITION =========================================================
+
+//! Measures the time from construction to destruction and records it for a
+//! stage of the global Profiler
+class ScopedTimer
+{
+public:
+
+    //! start timing stage \c name
+    explicit ScopedTimer(const char* name)
+        : name_(name), start_(std::chrono::steady_clock::now())
+    {}
+
+    //! stop timing and record
+    ~ScopedTimer()
+    {
+        Profiler& profiler = Profiler::instance();
+        if (profiler.enabled())
+        {
+            const std::chrono::duration<double> t = std::chrono::steady_clock::now() - start_;
+            profiler.add_time(name_, t.count());
+        }
+    }
+
+private:
+
+    const char* name_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+//=============================================================================
@@ -0,0 +1,262 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "RegionEvaluator.h"
+#include "Profiler.h"
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <cassert>
+
+using namespace pmp;
+
+//== IMPLEMENTATION ============================================================
+
+RegionEvaluator::
+RegionEvaluator(const MultilinearModel& mlm)
+    : mlm_(mlm), margin_(10.0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+RegionEvaluator::
+select(const RegionMap& regions, const std::vector<int>& labels,
+       const SurfaceMesh& skull)
+{
+    const unsigned int n_skin = mlm_.n_skin_vertices();
+
+    if (regions.skin_labels().size()  != n_skin ||
+        regions.skull_labels().size() != mlm_.n_skull_vertices() ||
+        skull.n_vertices() != mlm_.n_skull_vertices())
+    {
+        std::cerr << "[ERROR] in 'RegionEvaluator::select(...)' - Regions do not match the model" << std::endl;
+        return false;
+    }
+
+    labels_ = labels;
+    skin_vertices_.clear();
+    skull_vertices_.clear();
+    region_.clear();
+
+    // collect vertices region by region
+    std::vector<unsigned int> skin_region, skull_region;
+    for (unsigned int r=0; r<labels_.size(); ++r)
+    {
+        for (auto v : regions.skin_vertices(labels_[r]))
+        {
+            skin_vertices_.push_back(v);
+            skin_region.push_back(r);
+        }
+        for (auto v : regions.skull_vertices(labels_[r]))
+        {
+            skull_vertices_.push_back(v);
+            skull_region.push_back(r);
+        }
+    }
+    region_ = skin_region;
+    region_.insert(region_.end(), skull_region.begin(), skull_region.end());
+
+
+    // tensor rows, skin vertices first
+    rows_.clear();
+    rows_.reserve(3*region_.size());
+    for (auto v : skin_vertices_)
+        for (unsigned int d=0; d<3; ++d)
+            rows_.push_back(3*v + d);
+    for (auto v : skull_vertices_)
+        for (unsigned int d=0; d<3; ++d)
+            rows_.push_back(3*(n_skin + v) + d);
+
+
+    // thickness is measured to the skull surface. on the mean shape, collect
+    // the skull triangles within the closest distance plus a margin of each
+    // selected skin vertex; only their vertices are evaluated.
+    const unsigned int n_skull = mlm_.n_skull_vertices();
+    const std::vector<double>& mean = mlm_.mean();
+    std::vector<unsigned int> triangles, near;
+    if (!skin_vertices_.empty())
+    {
+        for (auto f : skull.faces())
+        {
+            unsigned int t[3], n = 0;
+            for (auto v : skull.vertices(f))
+            {
+                if (n < 3) t[n] = v.idx();
+                ++n;
+            }
+            if (n == 3)
+                triangles.insert(triangles.end(), t, t+3);
+        }
+
+        TriangleBVH full;
+        full.build(triangles, mean.data() + 3*n_skin, n_skull);
+
+        std::vector<bool> selected(triangles.size() / 3, false);
+        std::vector<unsigned int> candidates;
+        for (auto v : skin_vertices_)
+        {
+            const Eigen::Vector3d p(mean[3*v], mean[3*v+1], mean[3*v+2]);
+            const TriangleBVH::Hit hit = full.closest(p);
+            candidates.clear();
+            full.within(p, std::fabs(hit.distance) + margin_, candidates);
+            for (auto t : candidates)
+                selected[t] = true;
+        }
+        for (unsigned int t=0; t<selected.size(); ++t)
+            if (selected[t])
+                near.insert(near.end(), &triangles[3*t], &triangles[3*t] + 3);
+    }
+
+    if (!near.empty())
+    {
+        // skull vertices to evaluate: those of the neighborhood and the
+        // selected ones, in index order
+        std::vector<int> local(n_skull, -1);
+        for (auto v : near)           local[v] = 0;
+        for (auto v : skull_vertices_) local[v] = 0;
+
+        statistics_rows_.assign(rows_.begin(), rows_.begin() + 3*skin_vertices_.size());
+        std::vector<double> points;
+        unsigned int n_local = 0;
+        for (unsigned int v=0; v<n_skull; ++v)
+        {
+            if (local[v] < 0)
+                continue;
+            local[v] = n_local++;
+            for (unsigned int d=0; d<3; ++d)
+            {
+                statistics_rows_.push_back(3*(n_skin + v) + d);
+                points.push_back(mean[3*(n_skin + v) + d]);
+            }
+        }
+        for (auto& v : near)
+            v = local[v];
+
+        point_index_.clear();
+        for (unsigned int i=0; i<skin_vertices_.size(); ++i)
+            point_index_.push_back(i);
+        for (auto v : skull_vertices_)
+            point_index_.push_back(skin_vertices_.size() + local[v]);
+
+        bvh_.build(near, points.data(), n_local);
+    }
+    else
+    {
+        statistics_rows_ = rows_;
+        point_index_.resize(region_.size());
+        for (unsigned int i=0; i<region_.size(); ++i)
+            point_index_[i] = i;
+
+        bvh_.build(near, nullptr, 0);
+    }
+    hints_.assign(skin_vertices_.size(), -1);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+RegionEvaluator::
+evaluate(Eigen::VectorXd& points,
+         const Eigen::VectorXd& w_skull, const Eigen::VectorXd& w_fstt) const
+{
+    mlm_.evaluate_rows(points, rows_, w_skull, w_fstt);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+RegionEvaluator::
+statistics(std::vector<Statistics>& stats,
+           const Eigen::VectorXd& w_skull, const Eigen::VectorXd& w_fstt)
+{
+    mlm_.evaluate_rows(points_, statistics_rows_, w_skull, w_fstt);
+
+    ScopedTimer timer("regions/statistics");
+
+    const unsigned int n_regions = labels_.size();
+    const unsigned int n_skin    = skin_vertices_.size();
+    const unsigned int n         = region_.size();
+    const bool has_skull = (bvh_.n_triangles() > 0);
+    const std::vector<double>& mean = mlm_.mean();
+
+    if (has_skull)
+        bvh_.refit(points_.data() + 3*n_skin);
+
+
+    // per region: sum and squared sum of thickness and displacement
+    enum { THICKNESS, THICKNESS2, DISPLACEMENT, DISPLACEMENT2, N_SUMS };
+    std::vector<double> sums(N_SUMS*n_regions, 0.0);
+
+#pragma omp parallel
+    {
+        std::vector<double> local(N_SUMS*n_regions, 0.0);
+
+#pragma omp for nowait
+        for (int i=0; i<(int)n; ++i)
+        {
+            double* s = &local[N_SUMS*region_[i]];
+
+            const unsigned int j = point_index_[i];
+            const Eigen::Vector3d p(points_(3*j), points_(3*j+1), points_(3*j+2));
+            const unsigned int r = rows_[3*i];
+            const Eigen::Vector3d m(mean[r], mean[r+1], mean[r+2]);
+            const double displacement = (p - m).norm();
+            s[DISPLACEMENT]  += displacement;
+            s[DISPLACEMENT2] += displacement * displacement;
+
+            if (i < (int)n_skin && has_skull)
+            {
+                const TriangleBVH::Hit hit = bvh_.closest(p, hints_[i]);
+                hints_[i] = hit.triangle;
+                s[THICKNESS]  += hit.distance;
+                s[THICKNESS2] += hit.distance * hit.distance;
+            }
+        }
+
+#pragma omp critical
+        {
+            for (unsigned int j=0; j<sums.size(); ++j)
+                sums[j] += local[j];
+        }
+    }
+
+
+    // means and variances
+    stats.assign(n_regions, Statistics());
+    for (unsigned int r=0; r<n_regions; ++r)
+    {
+        Statistics& st = stats[r];
+        st.label            = labels_[r];
+        st.n_skin_vertices  = std::count(region_.begin(), region_.begin() + n_skin, r);
+        st.n_skull_vertices = std::count(region_.begin() + n_skin, region_.end(), r);
+
+        const double* s = &sums[N_SUMS*r];
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+
+        const unsigned int ns = st.n_skin_vertices;
+        st.thickness_mean     = (ns && has_skull) ? s[THICKNESS] / ns : nan;
+        st.thickness_variance = (ns && has_skull) ?
+            std::max(0.0, s[THICKNESS2] / ns - st.thickness_mean * st.thickness_mean) : nan;
+
+        const unsigned int nv = st.n_skin_vertices + st.n_skull_vertices;
+        st.displacement_mean     = nv ? s[DISPLACEMENT] / nv : nan;
+        st.displacement_variance = nv ?
+            std::max(0.0, s[DISPLACEMENT2] / nv - st.displacement_mean * st.displacement_mean) : nan;
+    }
+}
+
+//=============================================================================
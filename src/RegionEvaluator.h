@@ -0,0 +1,121 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+//== INCLUDES =================================================================
+
+#include <vector>
+#include <Eigen/Dense>
+#include <pmp/SurfaceMesh.h>
+
+#include "MultilinearModel.h"
+#include "RegionMap.h"
+#include "TriangleBVH.h"
+
+
+//== CLASS DEFINITION =========================================================
+
+//! Evaluates the multilinear model restricted to selected regions and
+//! computes per-region statistics. Only the tensor rows of the selected
+//! vertices are contracted by evaluate(). Soft tissue thickness is the
+//! signed distance of a skin vertex to the skull surface, independent of
+//! which regions are selected. statistics() therefore additionally evaluates
+//! the skull triangles near the selected skin vertices, i.e., those within a
+//! margin beyond the closest skull distance on the mean shape. Its cost is
+//! proportional to statistics_rows().size().
+class RegionEvaluator
+{
+public:
+
+    //! statistics of one region for one parameter set
+    struct Statistics
+    {
+        int label;                     //!< region label
+        unsigned int n_skin_vertices;  //!< number of skin vertices
+        unsigned int n_skull_vertices; //!< number of skull vertices
+        double thickness_mean;         //!< mean thickness of the skin vertices
+        double thickness_variance;     //!< variance of the thickness
+        double displacement_mean;      //!< mean distance of all vertices to the mean shape
+        double displacement_variance;  //!< variance of that distance
+    };
+
+    //! constructor
+    RegionEvaluator(const MultilinearModel& mlm);
+
+    //! set the margin (in model units) added to the closest skull distance
+    //! of each selected skin vertex on the mean shape when collecting the
+    //! skull neighborhood for thickness computation (default 10). call
+    //! before select().
+    void set_margin(double margin) { margin_ = margin; }
+
+    //! select the regions 'labels' of 'regions'. 'skull' provides the skull
+    //! triangles used for thickness computation.
+    bool select(const RegionMap& regions, const std::vector<int>& labels,
+                const pmp::SurfaceMesh& skull);
+
+    //! evaluate the selected vertices only. 'points' receives the values of
+    //! the tensor rows rows(), i.e., x,y,z of the selected skin vertices
+    //! followed by those of the selected skull vertices.
+    void evaluate(Eigen::VectorXd& points,
+                  const Eigen::VectorXd& w_skull, const Eigen::VectorXd& w_fstt) const;
+
+    //! evaluate the selected regions and compute their statistics in a
+    //! single parallel pass over their vertices
+    void statistics(std::vector<Statistics>& stats,
+                    const Eigen::VectorXd& w_skull, const Eigen::VectorXd& w_fstt);
+
+    //! tensor rows of the selected vertices
+    const std::vector<unsigned int>& rows() const { return rows_; }
+
+    //! tensor rows evaluated by statistics(): the selected skin rows followed
+    //! by the rows of the skull neighborhood and of the selected skull vertices
+    const std::vector<unsigned int>& statistics_rows() const { return statistics_rows_; }
+
+    //! selected skin vertices
+    const std::vector<unsigned int>& skin_vertices() const { return skin_vertices_; }
+
+    //! selected skull vertices
+    const std::vector<unsigned int>& skull_vertices() const { return skull_vertices_; }
+
+private:
+
+    //! the multilinear model
+    const MultilinearModel& mlm_;
+
+    //! selected labels
+    std::vector<int> labels_;
+    //! selected skin and skull vertices
+    std::vector<unsigned int> skin_vertices_, skull_vertices_;
+    //! region index (into labels_) of each selected vertex, skin first
+    std::vector<unsigned int> region_;
+    //! tensor rows of the selected vertices
+    std::vector<unsigned int> rows_;
+    //! tensor rows evaluated for the statistics: rows of the selected skin
+    //! vertices followed by the rows of the skull neighborhood and the
+    //! selected skull vertices if thickness is computed, otherwise rows_
+    std::vector<unsigned int> statistics_rows_;
+    //! index of each selected vertex' position in the statistics evaluation
+    std::vector<unsigned int> point_index_;
+
+    //! margin of the skull neighborhood
+    double margin_;
+
+    //! BVH over the skull triangles near the selected skin vertices
+    TriangleBVH bvh_;
+    //! closest skull triangle of each selected skin vertex in the last call
+    std::vector<int> hints_;
+    //! last evaluation
+    Eigen::VectorXd points_;
+};
+
+//=============================================================================
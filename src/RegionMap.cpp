@@ -0,0 +1,167 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "RegionMap.h"
+#include "utils.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <set>
+
+//== HELPER ===================================================================
+
+namespace {
+
+//! load integer labels of 'n' vertices, or -1 for all if 'filename' is empty
+bool load_labels(std::vector<int>& labels, const std::string& filename, unsigned int n)
+{
+    labels.assign(n, -1);
+    if (filename.empty())
+        return true;
+
+    std::vector<double> values;
+    if (!load_scalars(values, filename))
+        return false;
+
+    if (values.size() != n)
+    {
+        std::cerr << "[ERROR] in 'RegionMap::load(...)' - " << filename << " has "
+                  << values.size() << " labels for " << n << " vertices" << std::endl;
+        return false;
+    }
+
+    for (unsigned int i=0; i<n; ++i)
+        labels[i] = int(values[i]);
+
+    return true;
+}
+
+//! indices of all entries of 'labels' equal to 'label'
+std::vector<unsigned int> select(const std::vector<int>& labels, int label)
+{
+    std::vector<unsigned int> result;
+    for (unsigned int i=0; i<labels.size(); ++i)
+        if (labels[i] == label)
+            result.push_back(i);
+    return result;
+}
+
+} // anonymous namespace
+
+
+//== IMPLEMENTATION ============================================================
+
+RegionMap::
+RegionMap()
+{
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+RegionMap::
+load(const std::string& filename_skin, const std::string& filename_skull,
+     unsigned int n_skin_vertices, unsigned int n_skull_vertices)
+{
+    return load_labels(skin_labels_,  filename_skin,  n_skin_vertices) &&
+           load_labels(skull_labels_, filename_skull, n_skull_vertices);
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+RegionMap::
+load_names(const std::string& filename)
+{
+    std::ifstream ifs(filename);
+    if (!ifs)
+    {
+        std::cerr << "[ERROR] in 'RegionMap::load_names(...)' - Can't open " << filename << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(ifs, line))
+    {
+        std::istringstream iss(line);
+        int label;
+        std::string name;
+        if (iss >> label >> name)
+            names_[label] = name;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+RegionMap::
+set_labels(const std::vector<int>& skin_labels, const std::vector<int>& skull_labels)
+{
+    skin_labels_  = skin_labels;
+    skull_labels_ = skull_labels;
+}
+
+//-----------------------------------------------------------------------------
+
+std::vector<int>
+RegionMap::
+labels() const
+{
+    std::set<int> labels(skin_labels_.begin(), skin_labels_.end());
+    labels.insert(skull_labels_.begin(), skull_labels_.end());
+    labels.erase(-1);
+    return std::vector<int>(labels.begin(), labels.end());
+}
+
+//-----------------------------------------------------------------------------
+
+std::string
+RegionMap::
+name(int label) const
+{
+    auto it = names_.find(label);
+    return (it != names_.end()) ? it->second : std::to_string(label);
+}
+
+//-----------------------------------------------------------------------------
+
+int
+RegionMap::
+label(const std::string& name) const
+{
+    for (const auto& n : names_)
+        if (n.second == name)
+            return n.first;
+    return -1;
+}
+
+//-----------------------------------------------------------------------------
+
+std::vector<unsigned int>
+RegionMap::
+skin_vertices(int label) const
+{
+    return select(skin_labels_, label);
+}
+
+//-----------------------------------------------------------------------------
+
+std::vector<unsigned int>
+RegionMap::
+skull_vertices(int label) const
+{
+    return select(skull_labels_, label);
+}
+
+//=============================================================================
@@ -0,0 +1,76 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+//== INCLUDES =================================================================
+
+#include <vector>
+#include <string>
+#include <map>
+
+
+//== CLASS DEFINITION =========================================================
+
+//! Semantic segmentation of the skin and skull meshes into regions (e.g.
+//! nose, lips, chin, orbits), given by one integer label per vertex. Skin
+//! and skull vertices with the same label belong to the same region.
+class RegionMap
+{
+public:
+
+    //! constructor
+    RegionMap();
+
+    //! load per-vertex labels of skin and skull from text files with one
+    //! integer per vertex. either filename may be empty, in which case all
+    //! vertices of that mesh get label -1 (unlabeled).
+    bool load(const std::string& filenameSkin, const std::string& filenameSkull,
+              unsigned int nSkinVertices, unsigned int nSkullVertices);
+
+    //! load region names from a text file with lines "<label> <name>"
+    bool load_names(const std::string& filename);
+
+    //! set per-vertex labels directly
+    void set_labels(const std::vector<int>& skinLabels, const std::vector<int>& skullLabels);
+
+    //! all labels used by skin or skull vertices, in increasing order
+    //! (excluding -1)
+    std::vector<int> labels() const;
+
+    //! name of region 'label', or the label as string if it has no name
+    std::string name(int label) const;
+
+    //! label of region 'name', or -1 if there is none
+    int label(const std::string& name) const;
+
+    //! skin vertices of region 'label'
+    std::vector<unsigned int> skin_vertices(int label) const;
+
+    //! skull vertices of region 'label' (indices start at 0)
+    std::vector<unsigned int> skull_vertices(int label) const;
+
+    //! per-vertex labels of skin vertices
+    const std::vector<int>& skin_labels() const { return skin_labels_; }
+
+    //! per-vertex labels of skull vertices
+    const std::vector<int>& skull_labels() const { return skull_labels_; }
+
+private:
+
+    //! per-vertex labels
+    std::vector<int> skin_labels_, skull_labels_;
+    //! region names by label
+    std::map<int, std::string> names_;
+};
+
+//=============================================================================
@@ -0,0 +1,107 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "SkinReconstruction.h"
+#include "Profiler.h"
+#include <random>
+#include <cassert>
+#include <cmath>
+
+//== IMPLEMENTATION ============================================================
+
+SkinReconstruction::
+SkinReconstruction(const MultilinearModel& mlm)
+    : mlm_(mlm)
+{
+    // Gaussian prior fitted to the FSTT parameters of the training data
+    const Eigen::MatrixXd& U = mlm_.U_fstt();
+    assert(U.rows() > 1);
+
+    fstt_mean_ = U.colwise().mean().transpose();
+    const Eigen::MatrixXd centered = U.rowwise() - fstt_mean_.transpose();
+    fstt_covariance_ = centered.transpose() * centered / double(U.rows() - 1);
+
+    // symmetric square root, robust against a singular covariance
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eigen(fstt_covariance_);
+    fstt_factor_ = eigen.eigenvectors() *
+                   eigen.eigenvalues().cwiseMax(0.0).cwiseSqrt().asDiagonal();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+SkinReconstruction::
+set_skull(const Eigen::VectorXd& w_skull)
+{
+    mlm_.contract_skull(contracted_, w_skull);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+SkinReconstruction::
+expected(Eigen::VectorXd& points) const
+{
+    assert(contracted_.rows() == mlm_.dim0());
+
+    // the model is linear in w_fstt, so the expectation is the evaluation
+    // at the prior mean
+    mlm_.evaluate_contracted(points, contracted_, fstt_mean_);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+SkinReconstruction::
+skin_stddev(Eigen::VectorXd& stddev) const
+{
+    assert(contracted_.rows() == mlm_.dim0());
+
+    // covariance of a vertex p = M w_fstt is M Sigma M^T = (M L)(M L)^T,
+    // its trace is the squared norm of the three rows of M L
+    const unsigned int n = mlm_.n_skin_vertices();
+    const Eigen::MatrixXd ML = contracted_.topRows(3*n) * fstt_factor_;
+
+    stddev.resize(n);
+    for (unsigned int v=0; v<n; ++v)
+        stddev(v) = std::sqrt(ML.middleRows(3*v, 3).squaredNorm());
+}
+
+//-----------------------------------------------------------------------------
+
+void
+SkinReconstruction::
+sample(Eigen::MatrixXd& points, unsigned int n_samples, unsigned int seed,
+       Eigen::MatrixXd* w_fstt) const
+{
+    assert(contracted_.rows() == mlm_.dim0());
+    ScopedTimer timer("reconstruction/sample");
+
+    // FSTT parameters from the prior
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> normal;
+    Eigen::MatrixXd z(mlm_.dim2(), n_samples);
+    for (unsigned int s=0; s<n_samples; ++s)
+        for (unsigned int k=0; k<mlm_.dim2(); ++k)
+            z(k,s) = normal(rng);
+    const Eigen::MatrixXd w = (fstt_factor_ * z).colwise() + fstt_mean_;
+
+
+    // all samples in one matrix product with the contracted tensor, plus mean
+    points.noalias() = contracted_ * w;
+    points.colwise() += Eigen::Map<const Eigen::VectorXd>(mlm_.mean().data(), mlm_.dim0());
+
+    if (w_fstt)
+        *w_fstt = w;
+}
+
+//=============================================================================
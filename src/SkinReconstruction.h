@@ -0,0 +1,74 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+//== INCLUDES =================================================================
+
+#include <Eigen/Dense>
+
+#include "MultilinearModel.h"
+
+
+//== CLASS DEFINITION =========================================================
+
+//! Craniofacial reconstruction: predicts the skin surface for a fitted skull
+//! by marginalizing over the FSTT distribution. The FSTT prior is a Gaussian
+//! fitted to the rows of U_fstt. The tensor is contracted with the skull
+//! parameters once; since the model is linear in the FSTT parameters, the
+//! expected head, per-vertex uncertainties, and any number of samples are
+//! then cheap matrix products with the contracted tensor.
+class SkinReconstruction
+{
+public:
+
+    //! constructor, fits the FSTT prior
+    SkinReconstruction(const MultilinearModel& mlm);
+
+    //! set the fitted skull parameters
+    void set_skull(const Eigen::VectorXd& w_skull);
+
+    //! expected vertex coordinates of skin and skull over the FSTT prior
+    void expected(Eigen::VectorXd& points) const;
+
+    //! standard deviation of each skin vertex' position over the FSTT prior,
+    //! i.e., the square root of the trace of its covariance
+    void skin_stddev(Eigen::VectorXd& stddev) const;
+
+    //! draw \c n_samples FSTT parameters from the prior and evaluate them.
+    //! column s of 'points' receives the coordinates of sample s, column s of
+    //! 'w_fstt' (if given) its FSTT parameters.
+    void sample(Eigen::MatrixXd& points, unsigned int n_samples, unsigned int seed,
+                Eigen::MatrixXd* w_fstt = nullptr) const;
+
+    //! mean of the FSTT prior
+    const Eigen::VectorXd& fstt_mean() const { return fstt_mean_; }
+
+    //! covariance of the FSTT prior
+    const Eigen::MatrixXd& fstt_covariance() const { return fstt_covariance_; }
+
+private:
+
+    //! the multilinear model
+    const MultilinearModel& mlm_;
+
+    //! mean and covariance of the FSTT prior
+    Eigen::VectorXd fstt_mean_;
+    Eigen::MatrixXd fstt_covariance_;
+    //! factor L of the covariance L*L^T, maps standard normal to prior samples
+    Eigen::MatrixXd fstt_factor_;
+
+    //! tensor contracted with the skull parameters (dim0 x dim2)
+    Eigen::MatrixXd contracted_;
+};
+
+//=============================================================================
@@ -0,0 +1,396 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "ThumbnailRenderer.h"
+#include "Profiler.h"
+#include <iostream>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cassert>
+
+// image I/O from the stb headers shipped with pmp. the implementation is
+// compiled with static linkage to not clash with the copy inside pmp.
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+#pragma GCC diagnostic ignored "-Wsign-compare"
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_JPEG
+#define STBI_ONLY_PNG
+#include <stb_image.h>
+#define STB_IMAGE_WRITE_STATIC
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+using namespace pmp;
+
+//== HELPER ===================================================================
+
+namespace {
+
+//! size of screen tiles that are rasterized in parallel
+const unsigned int tile_size = 32;
+
+//! edge function of (a,b) at p, positive if p is left of a->b
+inline float edge(float ax, float ay, float bx, float by, float px, float py)
+{
+    return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+}
+
+} // anonymous namespace
+
+
+//== IMPLEMENTATION ============================================================
+
+ThumbnailRenderer::
+ThumbnailRenderer(unsigned int width, unsigned int height)
+    : width_(std::max(width, 1u)), height_(std::max(height, 1u)),
+      rotation_(Eigen::Matrix3f::Identity()),
+      center_(Eigen::Vector3f::Zero()), scale_(0.0f),
+      draw_skin_(true), draw_skull_(true), skin_alpha_(1.0),
+      background_(1.0f, 1.0f, 1.0f)
+{
+    tiles_x_ = (width_  + tile_size - 1) / tile_size;
+    tiles_y_ = (height_ + tile_size - 1) / tile_size;
+
+    // same colors as the viewer
+    skin_.base_color  = Eigen::Vector3f(1.0f, 0.85f, 0.8f);
+    skull_.base_color = Eigen::Vector3f(0.7f, 0.7f, 0.7f);
+    skin_.matcap.width  = skin_.matcap.height  = 0;
+    skull_.matcap.width = skull_.matcap.height = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+ThumbnailRenderer::
+set_topology(const SurfaceMesh& skin, const SurfaceMesh& skull)
+{
+    return build_layer(skin, skin_) && build_layer(skull, skull_);
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+ThumbnailRenderer::
+build_layer(const SurfaceMesh& mesh, Layer& layer)
+{
+    layer.triangles.clear();
+    layer.triangles.reserve(3*mesh.n_faces());
+    for (auto f : mesh.faces())
+    {
+        unsigned int n = 0;
+        for (auto v : mesh.vertices(f))
+        {
+            layer.triangles.push_back(v.idx());
+            ++n;
+        }
+        if (n != 3)
+        {
+            std::cerr << "[ERROR] in 'ThumbnailRenderer::set_topology(...)' - Meshes have to be triangle meshes" << std::endl;
+            return false;
+        }
+    }
+
+    // vertex-triangle adjacency for gathering vertex normals in parallel
+    const unsigned int n_vertices = mesh.n_vertices();
+    layer.adjacency_offset.assign(n_vertices + 1, 0);
+    for (auto v : layer.triangles)
+        ++layer.adjacency_offset[v+1];
+    for (unsigned int v=0; v<n_vertices; ++v)
+        layer.adjacency_offset[v+1] += layer.adjacency_offset[v];
+
+    std::vector<unsigned int> fill(layer.adjacency_offset.begin(), layer.adjacency_offset.end() - 1);
+    layer.adjacency.resize(layer.triangles.size());
+    for (unsigned int i=0; i<layer.triangles.size(); ++i)
+        layer.adjacency[fill[layer.triangles[i]]++] = i / 3;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+ThumbnailRenderer::
+load_matcaps(const std::string& filename_skin, const std::string& filename_skull)
+{
+    return load_matcap(filename_skin, skin_.matcap) &&
+           load_matcap(filename_skull, skull_.matcap);
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+ThumbnailRenderer::
+load_matcap(const std::string& filename, Matcap& matcap)
+{
+    int width, height, channels;
+    unsigned char* data = stbi_load(filename.c_str(), &width, &height, &channels, 3);
+    if (!data)
+    {
+        std::cerr << "[ERROR] in 'ThumbnailRenderer::load_matcaps(...)' - Can't load " << filename << std::endl;
+        return false;
+    }
+
+    matcap.width  = width;
+    matcap.height = height;
+    matcap.rgb.resize(3*width*height);
+    for (unsigned int i=0; i<matcap.rgb.size(); ++i)
+        matcap.rgb[i] = data[i] / 255.0f;
+
+    stbi_image_free(data);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ThumbnailRenderer::
+set_view(const Eigen::VectorXd& points, double yaw, double pitch)
+{
+    const unsigned int n = points.size() / 3;
+    if (!n) return;
+
+    Eigen::Map<const Eigen::Matrix3Xd> P(points.data(), 3, n);
+    const Eigen::Vector3d bmin = P.rowwise().minCoeff();
+    const Eigen::Vector3d bmax = P.rowwise().maxCoeff();
+    const Eigen::Vector3d center = 0.5 * (bmin + bmax);
+    const double radius = (P.colwise() - center).colwise().norm().maxCoeff();
+
+    const float deg = float(M_PI / 180.0);
+    rotation_ = (Eigen::AngleAxisf(pitch * deg, Eigen::Vector3f::UnitX()) *
+                 Eigen::AngleAxisf(yaw   * deg, Eigen::Vector3f::UnitY())).toRotationMatrix();
+    center_ = center.cast<float>();
+    scale_  = (radius > 0.0) ? 0.95f * std::min(width_, height_) / float(2.0 * radius) : 1.0f;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ThumbnailRenderer::
+render(const Eigen::VectorXd& points)
+{
+    ScopedTimer timer("render/thumbnail");
+
+    const unsigned int n_skin  = skin_.adjacency_offset.size()  ? skin_.adjacency_offset.size()  - 1 : 0;
+    const unsigned int n_skull = skull_.adjacency_offset.size() ? skull_.adjacency_offset.size() - 1 : 0;
+    assert(points.size() == 3*(n_skin + n_skull));
+
+    if (scale_ <= 0.0f)
+        set_view(points);
+
+    if (draw_skull_) render_layer(skull_, points.data() + 3*n_skin, n_skull);
+    if (draw_skin_)  render_layer(skin_,  points.data(), n_skin);
+
+
+    // composite skin over skull
+    const unsigned int n_pixels = width_ * height_;
+    const float alpha = std::min(std::max(float(skin_alpha_), 0.0f), 1.0f);
+    image_.resize(3*n_pixels);
+
+#pragma omp parallel for
+    for (int i=0; i<(int)n_pixels; ++i)
+    {
+        Eigen::Vector3f c = background_;
+
+        const bool skull = draw_skull_ && skull_.depth[i] > -FLT_MAX;
+        if (skull)
+            c = skull_.color[i];
+
+        if (draw_skin_ && skin_.depth[i] > -FLT_MAX &&
+            (!skull || skin_.depth[i] >= skull_.depth[i]))
+            c = alpha * skin_.color[i] + (1.0f - alpha) * c;
+
+        for (int j=0; j<3; ++j)
+            image_[3*i+j] = (unsigned char)(std::min(std::max(c[j], 0.0f), 1.0f) * 255.0f + 0.5f);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ThumbnailRenderer::
+render_layer(Layer& layer, const double* points, unsigned int n_vertices)
+{
+    const unsigned int n_triangles = layer.triangles.size() / 3;
+    layer.screen.resize(n_vertices);
+    layer.normals.resize(n_vertices);
+    layer.face_normals.resize(n_triangles);
+    layer.setup.resize(n_triangles);
+
+
+    // transform vertices into screen space (x,y in pixels, z towards the viewer)
+#pragma omp parallel for
+    for (int v=0; v<(int)n_vertices; ++v)
+    {
+        const Eigen::Vector3f p = rotation_ * (Eigen::Vector3f(points[3*v], points[3*v+1], points[3*v+2]) - center_);
+        layer.screen[v] = Eigen::Vector3f(0.5f*width_ + scale_*p[0], 0.5f*height_ - scale_*p[1], p[2]);
+    }
+
+
+    // triangle setup: view-space normals, back-face culling, bounding boxes
+#pragma omp parallel for
+    for (int t=0; t<(int)n_triangles; ++t)
+    {
+        const unsigned int* tri = &layer.triangles[3*t];
+        const Eigen::Vector3f a(points[3*tri[0]], points[3*tri[0]+1], points[3*tri[0]+2]);
+        const Eigen::Vector3f b(points[3*tri[1]], points[3*tri[1]+1], points[3*tri[1]+2]);
+        const Eigen::Vector3f c(points[3*tri[2]], points[3*tri[2]+1], points[3*tri[2]+2]);
+        const Eigen::Vector3f n = rotation_ * (b - a).cross(c - a);
+        layer.face_normals[t] = n;
+
+        Setup& s = layer.setup[t];
+        for (int i=0; i<3; ++i)
+        {
+            s.x[i] = layer.screen[tri[i]][0];
+            s.y[i] = layer.screen[tri[i]][1];
+            s.z[i] = layer.screen[tri[i]][2];
+        }
+        s.area = edge(s.x[0], s.y[0], s.x[1], s.y[1], s.x[2], s.y[2]);
+        s.xmin = std::max(0, int(std::floor(std::min(std::min(s.x[0], s.x[1]), s.x[2]))));
+        s.ymin = std::max(0, int(std::floor(std::min(std::min(s.y[0], s.y[1]), s.y[2]))));
+        s.xmax = std::min(int(width_)  - 1, int(std::ceil(std::max(std::max(s.x[0], s.x[1]), s.x[2]))));
+        s.ymax = std::min(int(height_) - 1, int(std::ceil(std::max(std::max(s.y[0], s.y[1]), s.y[2]))));
+
+        // cull back-facing, degenerate, and off-screen triangles
+        if (n[2] <= 0.0f || s.xmin > s.xmax || s.ymin > s.ymax)
+            s.area = 0.0f;
+    }
+
+
+    // vertex normals, gathered from incident triangles
+#pragma omp parallel for
+    for (int v=0; v<(int)n_vertices; ++v)
+    {
+        Eigen::Vector3f n = Eigen::Vector3f::Zero();
+        for (unsigned int i=layer.adjacency_offset[v]; i<layer.adjacency_offset[v+1]; ++i)
+            n += layer.face_normals[layer.adjacency[i]];
+        const float l = n.norm();
+        layer.normals[v] = (l > 0.0f) ? Eigen::Vector3f(n / l) : Eigen::Vector3f(0.0f, 0.0f, 1.0f);
+    }
+
+
+    // bin triangles into tiles
+    layer.bins.resize(tiles_x_ * tiles_y_);
+    for (auto& bin : layer.bins)
+        bin.clear();
+    for (unsigned int t=0; t<n_triangles; ++t)
+    {
+        const Setup& s = layer.setup[t];
+        if (s.area == 0.0f) continue;
+        for (int ty=s.ymin/tile_size; ty<=int(s.ymax/tile_size); ++ty)
+            for (int tx=s.xmin/tile_size; tx<=int(s.xmax/tile_size); ++tx)
+                layer.bins[ty*tiles_x_ + tx].push_back(t);
+    }
+
+
+    // rasterize tiles in parallel, each thread owns the pixels of its tile
+    layer.depth.resize(width_ * height_);
+    layer.color.resize(width_ * height_);
+#pragma omp parallel for schedule(dynamic)
+    for (int tile=0; tile<(int)layer.bins.size(); ++tile)
+        rasterize_tile(layer, tile);
+}
+
+//-----------------------------------------------------------------------------
+
+void
+ThumbnailRenderer::
+rasterize_tile(Layer& layer, unsigned int tile) const
+{
+    const int x0 = (tile % tiles_x_) * tile_size;
+    const int y0 = (tile / tiles_x_) * tile_size;
+    const int x1 = std::min(x0 + int(tile_size), int(width_))  - 1;
+    const int y1 = std::min(y0 + int(tile_size), int(height_)) - 1;
+
+    for (int y=y0; y<=y1; ++y)
+        for (int x=x0; x<=x1; ++x)
+            layer.depth[y*width_ + x] = -FLT_MAX;
+
+    const Matcap& matcap = layer.matcap;
+
+    for (auto t : layer.bins[tile])
+    {
+        const Setup& s = layer.setup[t];
+        const unsigned int* tri = &layer.triangles[3*t];
+        const float inv_area = 1.0f / s.area;
+
+        const int xmin = std::max(s.xmin, x0), xmax = std::min(s.xmax, x1);
+        const int ymin = std::max(s.ymin, y0), ymax = std::min(s.ymax, y1);
+
+        for (int y=ymin; y<=ymax; ++y)
+        {
+            const float py = y + 0.5f;
+            for (int x=xmin; x<=xmax; ++x)
+            {
+                const float px = x + 0.5f;
+
+                // barycentric coordinates, all non-negative inside
+                const float b0 = edge(s.x[1], s.y[1], s.x[2], s.y[2], px, py) * inv_area;
+                const float b1 = edge(s.x[2], s.y[2], s.x[0], s.y[0], px, py) * inv_area;
+                const float b2 = 1.0f - b0 - b1;
+                if (b0 < 0.0f || b1 < 0.0f || b2 < 0.0f) continue;
+
+                const float z = b0*s.z[0] + b1*s.z[1] + b2*s.z[2];
+                float& depth = layer.depth[y*width_ + x];
+                if (z <= depth) continue;
+                depth = z;
+
+                Eigen::Vector3f n = b0 * layer.normals[tri[0]] +
+                                    b1 * layer.normals[tri[1]] +
+                                    b2 * layer.normals[tri[2]];
+                n.normalize();
+
+                Eigen::Vector3f& color = layer.color[y*width_ + x];
+                if (matcap.width > 0)
+                {
+                    // mat-cap lookup by the view-space normal
+                    const int u = std::min(std::max(int((0.5f + 0.5f*n[0]) * matcap.width),  0), matcap.width  - 1);
+                    const int v = std::min(std::max(int((0.5f - 0.5f*n[1]) * matcap.height), 0), matcap.height - 1);
+                    const float* c = &matcap.rgb[3*(v*matcap.width + u)];
+                    color = Eigen::Vector3f(c[0], c[1], c[2]);
+                }
+                else
+                {
+                    color = (0.2f + 0.8f * std::max(n[2], 0.0f)) * layer.base_color;
+                }
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool
+ThumbnailRenderer::
+write_png(const std::string& filename) const
+{
+    ScopedTimer timer("render/png");
+
+    if (image_.empty() ||
+        !stbi_write_png(filename.c_str(), width_, height_, 3, image_.data(), 3*width_))
+    {
+        std::cerr << "[ERROR] in 'ThumbnailRenderer::write_png(...)' - Can't write " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+//=============================================================================
@@ -0,0 +1,153 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+//== INCLUDES =================================================================
+
+#include <vector>
+#include <string>
+#include <Eigen/Dense>
+#include <pmp/SurfaceMesh.h>
+
+
+//== CLASS DEFINITION =========================================================
+
+//! Multithreaded software rasterizer for preview images of evaluated samples
+//! without an OpenGL context, e.g. during bulk sampling on headless
+//! machines. Skin and skull are shaded with mat-caps as in the viewer, the
+//! skin optionally semi-transparent. Topology-dependent setup (triangle
+//! lists, vertex-triangle adjacency) is done once; per image, vertices are
+//! transformed, triangles are set up and binned into screen tiles, and the
+//! tiles are rasterized in parallel.
+class ThumbnailRenderer
+{
+public:
+
+    //! constructor
+    ThumbnailRenderer(unsigned int width = 256, unsigned int height = 256);
+
+    //! set triangle topology of skin and skull
+    bool set_topology(const pmp::SurfaceMesh& skin, const pmp::SurfaceMesh& skull);
+
+    //! load mat-cap images for skin and skull (e.g. matcap-skin.jpg and
+    //! matcap-bone.jpg of the model directory). without mat-caps, a simple
+    //! diffuse shading is used.
+    bool load_matcaps(const std::string& filenameSkin, const std::string& filenameSkull);
+
+    //! fit an orthographic view to the bounding sphere of 'points' (skin and
+    //! skull coordinates, e.g. the mean), rotated by 'yaw' around the y-axis
+    //! and 'pitch' around the x-axis (in degrees)
+    void set_view(const Eigen::VectorXd& points, double yaw = 0.0, double pitch = 0.0);
+
+    //! choose which meshes to draw
+    void set_layers(bool skin, bool skull) { draw_skin_ = skin; draw_skull_ = skull; }
+
+    //! set opacity of the skin in [0,1]
+    void set_skin_alpha(double alpha) { skin_alpha_ = alpha; }
+
+    //! set background color
+    void set_background(const Eigen::Vector3f& color) { background_ = color; }
+
+    //! render a sample given as flat coordinate vector (skin vertices first,
+    //! as returned by MultilinearModel::evaluate)
+    void render(const Eigen::VectorXd& points);
+
+    //! the rendered image as 8 bit RGB
+    const std::vector<unsigned char>& image() const { return image_; }
+
+    //! write the rendered image as PNG file
+    bool write_png(const std::string& filename) const;
+
+    //! image width
+    unsigned int width() const { return width_; }
+    //! image height
+    unsigned int height() const { return height_; }
+
+private:
+
+    //! a mat-cap image with float RGB values
+    struct Matcap
+    {
+        int width, height;
+        std::vector<float> rgb;
+    };
+
+    //! triangle after setup in screen space
+    struct Setup
+    {
+        float x[3], y[3], z[3];   //!< screen coordinates and depth
+        float area;               //!< twice the signed screen area
+        int xmin, xmax, ymin, ymax;
+    };
+
+    //! one rendered mesh: topology caches and per-image buffers
+    struct Layer
+    {
+        //! triangle vertex indices
+        std::vector<unsigned int> triangles;
+        //! triangles incident to each vertex (compressed rows)
+        std::vector<unsigned int> adjacency_offset, adjacency;
+        //! mat-cap, and base color for diffuse shading without mat-cap
+        Matcap matcap;
+        Eigen::Vector3f base_color;
+
+        //! per-image: screen positions, view-space normals, triangle setup
+        std::vector<Eigen::Vector3f> screen, normals, face_normals;
+        std::vector<Setup> setup;
+        //! per-image: triangles per screen tile
+        std::vector< std::vector<unsigned int> > bins;
+
+        //! per-image: depth and color
+        std::vector<float> depth;
+        std::vector<Eigen::Vector3f> color;
+    };
+
+    //! build triangle list and adjacency of a mesh
+    static bool build_layer(const pmp::SurfaceMesh& mesh, Layer& layer);
+
+    //! load a mat-cap image
+    static bool load_matcap(const std::string& filename, Matcap& matcap);
+
+    //! render one layer from 'points' (coordinates of that mesh only)
+    void render_layer(Layer& layer, const double* points, unsigned int n_vertices);
+
+    //! rasterize the triangles binned into tile 'tile'
+    void rasterize_tile(Layer& layer, unsigned int tile) const;
+
+private:
+
+    //! image size
+    unsigned int width_, height_;
+    //! number of tiles in x and y
+    unsigned int tiles_x_, tiles_y_;
+
+    //! skin and skull layers
+    Layer skin_, skull_;
+
+    //! view rotation, center, and scale (pixels per model unit)
+    Eigen::Matrix3f rotation_;
+    Eigen::Vector3f center_;
+    float scale_;
+
+    //! which meshes to draw
+    bool draw_skin_, draw_skull_;
+    //! skin opacity
+    double skin_alpha_;
+    //! background color
+    Eigen::Vector3f background_;
+
+    //! final RGB image
+    std::vector<unsigned char> image_;
+};
+
+//=============================================================================
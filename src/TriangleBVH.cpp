@@ -0,0 +1,398 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "TriangleBVH.h"
+#include <algorithm>
+#include <unordered_map>
+#include <cfloat>
+#include <cmath>
+#include <cassert>
+#include <cstdint>
+
+//== HELPER ===================================================================
+
+namespace {
+
+//! maximum number of triangles per leaf
+const unsigned int max_leaf_size = 4;
+
+//! features of a triangle the closest point can lie on
+enum Feature { FACE, VERTEX_A, VERTEX_B, VERTEX_C, EDGE_AB, EDGE_BC, EDGE_CA };
+
+//! closest point to p on triangle (a,b,c) and the feature it lies on,
+//! following Ericson, Real-Time Collision Detection, Section 5.1.5
+Eigen::Vector3d closest_point_triangle(const Eigen::Vector3d& p,
+                                       const Eigen::Vector3d& a,
+                                       const Eigen::Vector3d& b,
+                                       const Eigen::Vector3d& c,
+                                       int& feature)
+{
+    const Eigen::Vector3d ab = b - a, ac = c - a, ap = p - a;
+    const double d1 = ab.dot(ap), d2 = ac.dot(ap);
+    if (d1 <= 0.0 && d2 <= 0.0) { feature = VERTEX_A; return a; }
+
+    const Eigen::Vector3d bp = p - b;
+    const double d3 = ab.dot(bp), d4 = ac.dot(bp);
+    if (d3 >= 0.0 && d4 <= d3) { feature = VERTEX_B; return b; }
+
+    const double vc = d1*d4 - d3*d2;
+    if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+    {
+        feature = EDGE_AB;
+        return a + d1 / (d1 - d3) * ab;
+    }
+
+    const Eigen::Vector3d cp = p - c;
+    const double d5 = ab.dot(cp), d6 = ac.dot(cp);
+    if (d6 >= 0.0 && d5 <= d6) { feature = VERTEX_C; return c; }
+
+    const double vb = d5*d2 - d1*d6;
+    if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+    {
+        feature = EDGE_CA;
+        return a + d2 / (d2 - d6) * ac;
+    }
+
+    const double va = d3*d6 - d5*d4;
+    if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0)
+    {
+        feature = EDGE_BC;
+        return b + (d4 - d3) / ((d4 - d3) + (d5 - d6)) * (c - b);
+    }
+
+    const double denom = 1.0 / (va + vb + vc);
+    feature = FACE;
+    return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+//! angle of triangle (a,b,c) at a
+double angle(const Eigen::Vector3d& a, const Eigen::Vector3d& b, const Eigen::Vector3d& c)
+{
+    const Eigen::Vector3d u = b - a, v = c - a;
+    return std::atan2(u.cross(v).norm(), u.dot(v));
+}
+
+} // anonymous namespace
+
+
+//== IMPLEMENTATION ============================================================
+
+TriangleBVH::
+TriangleBVH()
+    : n_vertices_(0), n_edges_(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+void
+TriangleBVH::
+build(const std::vector<unsigned int>& triangles,
+      const double* points, unsigned int n_vertices)
+{
+    assert(triangles.size() % 3 == 0);
+
+    triangles_  = triangles;
+    n_vertices_ = n_vertices;
+    points_.assign(points, points + 3*n_vertices);
+    const unsigned int n = n_triangles();
+
+
+    // enumerate edges
+    std::unordered_map<uint64_t, unsigned int> edges;
+    triangle_edges_.resize(3*n);
+    for (unsigned int t=0; t<n; ++t)
+    {
+        for (unsigned int i=0; i<3; ++i)
+        {
+            uint64_t v0 = triangles_[3*t+i], v1 = triangles_[3*t+(i+1)%3];
+            if (v0 > v1) std::swap(v0, v1);
+            auto it = edges.insert(std::make_pair((v0 << 32) | v1, (unsigned int)edges.size()));
+            triangle_edges_[3*t+i] = it.first->second;
+        }
+    }
+    n_edges_ = edges.size();
+
+
+    // build tree over triangle centroids
+    std::vector<Eigen::Vector3d> centroids(n);
+    for (unsigned int t=0; t<n; ++t)
+        centroids[t] = (vertex(triangles_[3*t]) + vertex(triangles_[3*t+1]) + vertex(triangles_[3*t+2])) / 3.0;
+
+    order_.resize(n);
+    for (unsigned int t=0; t<n; ++t)
+        order_[t] = t;
+
+    nodes_.clear();
+    nodes_.reserve(2*n / max_leaf_size + 1);
+    if (n) build_node(0, n, centroids);
+
+    refit(points);
+}
+
+//-----------------------------------------------------------------------------
+
+int
+TriangleBVH::
+build_node(unsigned int first, unsigned int count,
+           const std::vector<Eigen::Vector3d>& centroids)
+{
+    const int index = nodes_.size();
+    nodes_.push_back(Node());
+    nodes_[index].right = -1;
+    nodes_[index].first = first;
+    nodes_[index].count = count;
+
+    if (count <= max_leaf_size)
+        return index;
+
+    // split at the median centroid along the largest extent
+    Eigen::Vector3d cmin = centroids[order_[first]], cmax = cmin;
+    for (unsigned int i=first; i<first+count; ++i)
+    {
+        cmin = cmin.cwiseMin(centroids[order_[i]]);
+        cmax = cmax.cwiseMax(centroids[order_[i]]);
+    }
+    int axis;
+    (cmax - cmin).maxCoeff(&axis);
+
+    const unsigned int half = count / 2;
+    std::nth_element(order_.begin() + first, order_.begin() + first + half,
+                     order_.begin() + first + count,
+                     [&centroids, axis](unsigned int a, unsigned int b)
+                     { return centroids[a][axis] < centroids[b][axis]; });
+
+    build_node(first, half, centroids);
+    const int right = build_node(first + half, count - half, centroids);
+    nodes_[index].right = right;
+
+    return index;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+TriangleBVH::
+refit(const double* points)
+{
+    if (points != points_.data())
+        points_.assign(points, points + 3*n_vertices_);
+
+    // children have larger indices than their parent
+    for (int i=int(nodes_.size())-1; i>=0; --i)
+    {
+        Node& node = nodes_[i];
+        if (node.right < 0)
+        {
+            node.bmin = Eigen::Vector3d::Constant( DBL_MAX);
+            node.bmax = Eigen::Vector3d::Constant(-DBL_MAX);
+            for (unsigned int j=node.first; j<node.first+node.count; ++j)
+            {
+                for (unsigned int k=0; k<3; ++k)
+                {
+                    const Eigen::Vector3d v = vertex(triangles_[3*order_[j]+k]);
+                    node.bmin = node.bmin.cwiseMin(v);
+                    node.bmax = node.bmax.cwiseMax(v);
+                }
+            }
+        }
+        else
+        {
+            node.bmin = nodes_[i+1].bmin.cwiseMin(nodes_[node.right].bmin);
+            node.bmax = nodes_[i+1].bmax.cwiseMax(nodes_[node.right].bmax);
+        }
+    }
+
+    update_normals();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+TriangleBVH::
+update_normals()
+{
+    const unsigned int n = n_triangles();
+    face_normals_.assign(n, Eigen::Vector3d::Zero());
+    edge_normals_.assign(n_edges_, Eigen::Vector3d::Zero());
+    vertex_normals_.assign(n_vertices_, Eigen::Vector3d::Zero());
+
+    for (unsigned int t=0; t<n; ++t)
+    {
+        const Eigen::Vector3d a = vertex(triangles_[3*t]);
+        const Eigen::Vector3d b = vertex(triangles_[3*t+1]);
+        const Eigen::Vector3d c = vertex(triangles_[3*t+2]);
+        const Eigen::Vector3d nf = (b - a).cross(c - a).normalized();
+        face_normals_[t] = nf;
+
+        for (unsigned int i=0; i<3; ++i)
+            edge_normals_[triangle_edges_[3*t+i]] += nf;
+
+        vertex_normals_[triangles_[3*t]]   += angle(a, b, c) * nf;
+        vertex_normals_[triangles_[3*t+1]] += angle(b, c, a) * nf;
+        vertex_normals_[triangles_[3*t+2]] += angle(c, a, b) * nf;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+double
+TriangleBVH::
+box_distance(const Node& n, const Eigen::Vector3d& p) const
+{
+    const Eigen::Vector3d d = (n.bmin - p).cwiseMax(p - n.bmax).cwiseMax(0.0);
+    return d.squaredNorm();
+}
+
+//-----------------------------------------------------------------------------
+
+void
+TriangleBVH::
+test_triangle(unsigned int t, const Eigen::Vector3d& p,
+              double& best, int& best_triangle, int& best_feature,
+              Eigen::Vector3d& best_point) const
+{
+    int feature;
+    const Eigen::Vector3d q = closest_point_triangle(p,
+                                                     vertex(triangles_[3*t]),
+                                                     vertex(triangles_[3*t+1]),
+                                                     vertex(triangles_[3*t+2]),
+                                                     feature);
+    const double d = (q - p).squaredNorm();
+    if (d < best)
+    {
+        best          = d;
+        best_triangle = t;
+        best_feature  = feature;
+        best_point    = q;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+TriangleBVH::Hit
+TriangleBVH::
+closest(const Eigen::Vector3d& p, int hint) const
+{
+    double best = DBL_MAX;
+    int best_triangle = -1, best_feature = FACE;
+    Eigen::Vector3d best_point(0, 0, 0);
+
+    // a good initial guess prunes most of the tree
+    if (hint >= 0 && hint < (int)n_triangles())
+        test_triangle(hint, p, best, best_triangle, best_feature, best_point);
+
+    int stack[64];
+    int top = 0;
+    if (!nodes_.empty()) stack[top++] = 0;
+
+    while (top)
+    {
+        const int index = stack[--top];
+        const Node& node = nodes_[index];
+        if (box_distance(node, p) >= best)
+            continue;
+
+        if (node.right < 0)
+        {
+            for (unsigned int j=node.first; j<node.first+node.count; ++j)
+                test_triangle(order_[j], p, best, best_triangle, best_feature, best_point);
+        }
+        else
+        {
+            // visit the nearer child first
+            const int left  = index + 1;
+            const int right = node.right;
+            if (box_distance(nodes_[left], p) < box_distance(nodes_[right], p))
+            {
+                stack[top++] = right;
+                stack[top++] = left;
+            }
+            else
+            {
+                stack[top++] = left;
+                stack[top++] = right;
+            }
+        }
+    }
+
+    Hit hit;
+    hit.triangle = best_triangle;
+    hit.point    = best_point;
+    hit.distance = 0.0;
+    if (best_triangle < 0)
+        return hit;
+
+
+    // sign from the pseudo-normal of the closest feature
+    const unsigned int t = best_triangle;
+    Eigen::Vector3d normal;
+    switch (best_feature)
+    {
+        case VERTEX_A: normal = vertex_normals_[triangles_[3*t]];   break;
+        case VERTEX_B: normal = vertex_normals_[triangles_[3*t+1]]; break;
+        case VERTEX_C: normal = vertex_normals_[triangles_[3*t+2]]; break;
+        case EDGE_AB:  normal = edge_normals_[triangle_edges_[3*t]];   break;
+        case EDGE_BC:  normal = edge_normals_[triangle_edges_[3*t+1]]; break;
+        case EDGE_CA:  normal = edge_normals_[triangle_edges_[3*t+2]]; break;
+        default:       normal = face_normals_[t]; break;
+    }
+    const double d = std::sqrt(best);
+    hit.distance = ((p - best_point).dot(normal) < 0.0) ? -d : d;
+
+    return hit;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+TriangleBVH::
+within(const Eigen::Vector3d& p, double radius,
+       std::vector<unsigned int>& triangles) const
+{
+    const double r2 = radius * radius;
+
+    int stack[64];
+    int top = 0;
+    if (!nodes_.empty()) stack[top++] = 0;
+
+    while (top)
+    {
+        const int index = stack[--top];
+        const Node& node = nodes_[index];
+        if (box_distance(node, p) > r2)
+            continue;
+
+        if (node.right < 0)
+        {
+            for (unsigned int j=node.first; j<node.first+node.count; ++j)
+            {
+                const unsigned int t = order_[j];
+                int feature;
+                const Eigen::Vector3d q = closest_point_triangle(p,
+                                                                 vertex(triangles_[3*t]),
+                                                                 vertex(triangles_[3*t+1]),
+                                                                 vertex(triangles_[3*t+2]),
+                                                                 feature);
+                if ((q - p).squaredNorm() <= r2)
+                    triangles.push_back(t);
+            }
+        }
+        else
+        {
+            stack[top++] = index + 1;
+            stack[top++] = node.right;
+        }
+    }
+}
+
+//=============================================================================
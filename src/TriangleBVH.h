@@ -0,0 +1,116 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+//== INCLUDES =================================================================
+
+#include <vector>
+#include <Eigen/Dense>
+
+
+//== CLASS DEFINITION =========================================================
+
+//! Bounding volume hierarchy of axis-aligned boxes over a triangle mesh with
+//! fixed topology for closest-point and signed-distance queries. The tree is
+//! built once; when the vertices move, refit() updates the boxes in linear
+//! time. Signs are computed from angle-weighted pseudo-normals, i.e., points
+//! behind the surface w.r.t. its outward orientation get negative distances.
+class TriangleBVH
+{
+public:
+
+    //! result of a closest-point query
+    struct Hit
+    {
+        int triangle;            //!< closest triangle, -1 if none found
+        double distance;         //!< signed distance (negative behind the surface)
+        Eigen::Vector3d point;   //!< closest point on the surface
+    };
+
+    //! constructor
+    TriangleBVH();
+
+    //! build tree for triangles (three vertex indices each) over the vertex
+    //! coordinates 'points' (x,y,z of each vertex)
+    void build(const std::vector<unsigned int>& triangles,
+               const double* points, unsigned int n_vertices);
+
+    //! update boxes and normals for new vertex coordinates, same topology
+    void refit(const double* points);
+
+    //! closest point on the surface to 'p'. 'hint' is a triangle that is
+    //! likely to be close (e.g. the result of a previous query), or -1.
+    Hit closest(const Eigen::Vector3d& p, int hint = -1) const;
+
+    //! append all triangles closer than 'radius' to 'p' to 'triangles'
+    void within(const Eigen::Vector3d& p, double radius,
+                std::vector<unsigned int>& triangles) const;
+
+    //! number of triangles
+    unsigned int n_triangles() const { return triangles_.size() / 3; }
+
+private:
+
+    //! tree node, children of inner node i are i+1 and 'right'
+    struct Node
+    {
+        Eigen::Vector3d bmin, bmax;
+        int right;                 //!< right child, -1 for leaves
+        unsigned int first, count; //!< range in order_ for leaves
+    };
+
+    //! recursively build node for order_[first, first+count)
+    int build_node(unsigned int first, unsigned int count,
+                   const std::vector<Eigen::Vector3d>& centroids);
+
+    //! coordinates of vertex i
+    Eigen::Vector3d vertex(unsigned int i) const
+    {
+        return Eigen::Vector3d(points_[3*i], points_[3*i+1], points_[3*i+2]);
+    }
+
+    //! squared distance from p to the box of node n
+    double box_distance(const Node& n, const Eigen::Vector3d& p) const;
+
+    //! test triangle t against the current best hit
+    void test_triangle(unsigned int t, const Eigen::Vector3d& p,
+                       double& best, int& best_triangle, int& best_feature,
+                       Eigen::Vector3d& best_point) const;
+
+    //! update pseudo-normals for current coordinates
+    void update_normals();
+
+private:
+
+    //! triangle vertex indices
+    std::vector<unsigned int> triangles_;
+    //! current vertex coordinates
+    std::vector<double> points_;
+    //! number of vertices
+    unsigned int n_vertices_;
+
+    //! tree nodes, root is node 0
+    std::vector<Node> nodes_;
+    //! triangle order referenced by leaves
+    std::vector<unsigned int> order_;
+
+    //! edge index of the three edges of each triangle
+    std::vector<unsigned int> triangle_edges_;
+    //! number of edges
+    unsigned int n_edges_;
+
+    //! angle-weighted pseudo-normals of faces, edges, and vertices
+    std::vector<Eigen::Vector3d> face_normals_, edge_normals_, vertex_normals_;
+};
+
+//=============================================================================
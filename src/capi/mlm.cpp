@@ -0,0 +1,255 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "mlm.h"
+#include "MultilinearModel.h"
+
+#include <new>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+using namespace pmp;
+
+//== TYPES ====================================================================
+
+//! model handle: the model and its triangle topology
+struct mlm_model
+{
+    MultilinearModel mlm;
+    std::vector<unsigned int> skin_triangles, skull_triangles;
+};
+
+
+//== HELPER ===================================================================
+
+namespace {
+
+//! collect triangle indices and vertex coordinates of a mesh
+bool collect(const SurfaceMesh& mesh, std::vector<unsigned int>& triangles,
+             std::vector<double>& points)
+{
+    triangles.reserve(3*mesh.n_faces());
+    for (auto f : mesh.faces())
+    {
+        unsigned int n = 0;
+        for (auto v : mesh.vertices(f))
+        {
+            triangles.push_back(v.idx());
+            ++n;
+        }
+        if (n != 3) return false;
+    }
+
+    for (auto v : mesh.vertices())
+    {
+        const Point& p = mesh.position(v);
+        points.push_back(p[0]);
+        points.push_back(p[1]);
+        points.push_back(p[2]);
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+
+//== IMPLEMENTATION ============================================================
+
+int mlm_open(const char* dirname, int flags, mlm_model** model)
+{
+    if (!dirname || !model)
+        return MLM_ERROR_ARGUMENT;
+    *model = nullptr;
+
+    try
+    {
+        std::unique_ptr<mlm_model> m(new mlm_model);
+        const std::string dir(dirname);
+
+        // mean meshes provide topology and mean coordinates
+        SurfaceMesh skin, skull;
+        if (!skin.read(dir + "skin.off") || !skull.read(dir + "skull.off") ||
+            skin.n_vertices() == 0 || skull.n_vertices() == 0)
+            return MLM_ERROR_IO;
+
+        std::shared_ptr<std::vector<double> > mean = std::make_shared<std::vector<double> >();
+        if (!collect(skin,  m->skin_triangles,  *mean) ||
+            !collect(skull, m->skull_triangles, *mean))
+            return MLM_ERROR_IO;
+        m->mlm.set_means(mean, skin.n_vertices(), skull.n_vertices());
+
+        if (!m->mlm.load(dir, (flags & MLM_OPEN_MMAP) != 0))
+            return MLM_ERROR_IO;
+        if (m->mlm.dim0() != mean->size())
+            return MLM_ERROR_IO;
+
+        *model = m.release();
+        return MLM_OK;
+    }
+    catch (const std::bad_alloc&)
+    {
+        return MLM_ERROR_MEMORY;
+    }
+    catch (...)
+    {
+        return MLM_ERROR_IO;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void mlm_close(mlm_model* model)
+{
+    delete model;
+}
+
+//-----------------------------------------------------------------------------
+
+const char* mlm_error_string(int status)
+{
+    switch (status)
+    {
+        case MLM_OK:             return "success";
+        case MLM_ERROR_ARGUMENT: return "invalid argument";
+        case MLM_ERROR_IO:       return "cannot read model files";
+        case MLM_ERROR_MEMORY:   return "out of memory";
+    }
+    return "unknown error";
+}
+
+//-----------------------------------------------------------------------------
+
+unsigned int mlm_n_skin_vertices(const mlm_model* model)
+{
+    return model ? model->mlm.n_skin_vertices() : 0;
+}
+
+unsigned int mlm_n_skull_vertices(const mlm_model* model)
+{
+    return model ? model->mlm.n_skull_vertices() : 0;
+}
+
+unsigned int mlm_n_skin_triangles(const mlm_model* model)
+{
+    return model ? model->skin_triangles.size() / 3 : 0;
+}
+
+unsigned int mlm_n_skull_triangles(const mlm_model* model)
+{
+    return model ? model->skull_triangles.size() / 3 : 0;
+}
+
+unsigned int mlm_dim_skull(const mlm_model* model)
+{
+    return model ? model->mlm.dim1() : 0;
+}
+
+unsigned int mlm_dim_fstt(const mlm_model* model)
+{
+    return model ? model->mlm.dim2() : 0;
+}
+
+//-----------------------------------------------------------------------------
+
+int mlm_get_triangles(const mlm_model* model,
+                      unsigned int* skin_triangles,
+                      unsigned int* skull_triangles)
+{
+    if (!model)
+        return MLM_ERROR_ARGUMENT;
+
+    if (skin_triangles)
+        std::copy(model->skin_triangles.begin(), model->skin_triangles.end(), skin_triangles);
+    if (skull_triangles)
+        std::copy(model->skull_triangles.begin(), model->skull_triangles.end(), skull_triangles);
+
+    return MLM_OK;
+}
+
+//-----------------------------------------------------------------------------
+
+int mlm_get_mean_parameters(const mlm_model* model, double* w_skull, double* w_fstt)
+{
+    if (!model || !w_skull || !w_fstt)
+        return MLM_ERROR_ARGUMENT;
+
+    Eigen::Map<Eigen::VectorXd>(w_skull, model->mlm.dim1()) =
+        model->mlm.U_skull().colwise().mean().transpose();
+    Eigen::Map<Eigen::VectorXd>(w_fstt, model->mlm.dim2()) =
+        model->mlm.U_fstt().colwise().mean().transpose();
+
+    return MLM_OK;
+}
+
+//-----------------------------------------------------------------------------
+
+int mlm_evaluate(const mlm_model* model,
+                 const double* w_skull, const double* w_fstt,
+                 double* points)
+{
+    return mlm_evaluate_batch(model, 1, w_skull, w_fstt, points);
+}
+
+int mlm_evaluate_f(const mlm_model* model,
+                   const double* w_skull, const double* w_fstt,
+                   float* points)
+{
+    return mlm_evaluate_batch_f(model, 1, w_skull, w_fstt, points);
+}
+
+//-----------------------------------------------------------------------------
+
+int mlm_evaluate_batch(const mlm_model* model, unsigned int n_samples,
+                       const double* w_skull, const double* w_fstt,
+                       double* points)
+{
+    if (!model || !w_skull || !w_fstt || !points)
+        return MLM_ERROR_ARGUMENT;
+
+    model->mlm.evaluate_into(points, w_skull, w_fstt, n_samples);
+    return MLM_OK;
+}
+
+int mlm_evaluate_batch_f(const mlm_model* model, unsigned int n_samples,
+                         const double* w_skull, const double* w_fstt,
+                         float* points)
+{
+    if (!model || !w_skull || !w_fstt || !points)
+        return MLM_ERROR_ARGUMENT;
+
+    model->mlm.evaluate_into(points, w_skull, w_fstt, n_samples);
+    return MLM_OK;
+}
+
+//-----------------------------------------------------------------------------
+
+int mlm_jacobian(const mlm_model* model,
+                 const unsigned int* vertices, unsigned int n_vertices,
+                 const double* w_skull, const double* w_fstt,
+                 double* jacobian)
+{
+    if (!model || (n_vertices && !vertices) || !w_skull || !w_fstt || !jacobian)
+        return MLM_ERROR_ARGUMENT;
+
+    const unsigned int n = model->mlm.n_skin_vertices() + model->mlm.n_skull_vertices();
+    for (unsigned int i=0; i<n_vertices; ++i)
+        if (vertices[i] >= n)
+            return MLM_ERROR_ARGUMENT;
+
+    // row-major storage
+    const size_t n_cols = model->mlm.dim1() + model->mlm.dim2();
+    model->mlm.jacobian_into(jacobian, vertices, n_vertices, w_skull, w_fstt, n_cols, 1);
+    return MLM_OK;
+}
+
+//=============================================================================
@@ -0,0 +1,140 @@
+/*=============================================================================
+ *
+ *   Copyright (c) by Computer Graphics Group, Bielefeld University
+ *
+ * This work is licensed under a
+ * Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ * You should have received a copy of the license along with this
+ * work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *===========================================================================*/
+#ifndef MLM_H
+#define MLM_H
+/*===========================================================================*/
+
+/*! \file mlm.h
+ *  Plain C interface of the multilinear model (libmlm), e.g. for bindings
+ *  from other languages. All buffers are provided by the caller; evaluation
+ *  and Jacobian functions do not allocate memory. A model can be evaluated
+ *  concurrently from several threads.
+ *
+ *  Parameters are passed as dim_skull skull parameters and dim_fstt FSTT
+ *  parameters per sample. Vertex coordinates are stored as x,y,z of all skin
+ *  vertices followed by all skull vertices, i.e., 3*(n_skin + n_skull)
+ *  values per sample. Batches store samples one after the other.
+ */
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+#  if defined(MLM_BUILD)
+#    define MLM_API __declspec(dllexport)
+#  else
+#    define MLM_API __declspec(dllimport)
+#  endif
+#else
+#  define MLM_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*== TYPES ==================================================================*/
+
+/*! opaque model handle */
+typedef struct mlm_model mlm_model;
+
+/*! status codes */
+enum
+{
+    MLM_OK = 0,             /*!< success */
+    MLM_ERROR_ARGUMENT = 1, /*!< invalid argument (e.g. null pointer) */
+    MLM_ERROR_IO = 2,       /*!< model files could not be read */
+    MLM_ERROR_MEMORY = 3    /*!< out of memory */
+};
+
+/*! flags for mlm_open() */
+enum
+{
+    MLM_OPEN_MMAP = 1       /*!< evaluate the tensor in place from a read-only
+                                 memory mapping of its file (no copy, pages
+                                 are shared between processes) */
+};
+
+
+/*== FUNCTIONS ==============================================================*/
+
+/*! open the model stored in directory 'dirname' (including the trailing
+ *  slash, as for the viewer). 'flags' is 0 or MLM_OPEN_MMAP. */
+MLM_API int mlm_open(const char* dirname, int flags, mlm_model** model);
+
+/*! release a model */
+MLM_API void mlm_close(mlm_model* model);
+
+/*! description of a status code */
+MLM_API const char* mlm_error_string(int status);
+
+
+/*! number of skin vertices */
+MLM_API unsigned int mlm_n_skin_vertices(const mlm_model* model);
+/*! number of skull vertices */
+MLM_API unsigned int mlm_n_skull_vertices(const mlm_model* model);
+/*! number of skin triangles */
+MLM_API unsigned int mlm_n_skin_triangles(const mlm_model* model);
+/*! number of skull triangles */
+MLM_API unsigned int mlm_n_skull_triangles(const mlm_model* model);
+/*! number of skull parameters */
+MLM_API unsigned int mlm_dim_skull(const mlm_model* model);
+/*! number of FSTT parameters */
+MLM_API unsigned int mlm_dim_fstt(const mlm_model* model);
+
+/*! copy the vertex indices of the skin and skull triangles (3 per triangle,
+ *  skull indices start at 0). either pointer may be null. */
+MLM_API int mlm_get_triangles(const mlm_model* model,
+                              unsigned int* skin_triangles,
+                              unsigned int* skull_triangles);
+
+/*! copy the mean parameters (averages of the training subjects) */
+MLM_API int mlm_get_mean_parameters(const mlm_model* model,
+                                    double* w_skull, double* w_fstt);
+
+
+/*! evaluate one parameter set into double coordinates */
+MLM_API int mlm_evaluate(const mlm_model* model,
+                         const double* w_skull, const double* w_fstt,
+                         double* points);
+
+/*! evaluate one parameter set into float coordinates */
+MLM_API int mlm_evaluate_f(const mlm_model* model,
+                           const double* w_skull, const double* w_fstt,
+                           float* points);
+
+/*! evaluate 'n_samples' parameter sets into double coordinates, streaming
+ *  the tensor only once */
+MLM_API int mlm_evaluate_batch(const mlm_model* model, unsigned int n_samples,
+                               const double* w_skull, const double* w_fstt,
+                               double* points);
+
+/*! evaluate 'n_samples' parameter sets into float coordinates */
+MLM_API int mlm_evaluate_batch_f(const mlm_model* model, unsigned int n_samples,
+                                 const double* w_skull, const double* w_fstt,
+                                 float* points);
+
+/*! Jacobian of the coordinates of the given vertices (skin first, then
+ *  skull) w.r.t. the parameters, as row-major (3*n_vertices) x
+ *  (dim_skull + dim_fstt) matrix whose first dim_skull columns belong to
+ *  the skull parameters */
+MLM_API int mlm_jacobian(const mlm_model* model,
+                         const unsigned int* vertices, unsigned int n_vertices,
+                         const double* w_skull, const double* w_fstt,
+                         double* jacobian);
+
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+#endif /* MLM_H */
+/*===========================================================================*/
@@ -12,6 +12,10 @@
 
 #include "MLMViewer.h"
 #include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
 
 //=============================================================================
 
@@ -19,16 +23,29 @@ int main(int argc, char **argv)
 {
     MLMViewer window("MLMViewer", 1024, 768);
 
-    bool ok_load = false;
-    if (argc == 2)
-        ok_load = window.load_mlm(argv[1]);
-    else
-        ok_load = window.load_mlm("../data/");
+    // model directories and memory budget for loaded models
+    std::vector<std::string> dirs;
+    for (int i=1; i<argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "-m" && i+1 < argc)
+            window.set_memory_budget(size_t(std::max(std::atoi(argv[++i]), 0)) * 1048576);
+        else
+            dirs.push_back(arg);
+    }
+    if (dirs.empty())
+        dirs.push_back("../data/");
+
+    const bool ok_load = window.load_mlm(dirs[0].c_str());
+
+    // further models can be swapped in from the GUI
+    for (size_t i=1; i<dirs.size(); ++i)
+        window.add_mlm(dirs[i].c_str());
 
     if (!ok_load)
     {
         std::cerr << "[ERROR] Can't load multilinear model!" << std::endl
-                  << "Usage: './mlmviewer <directory name where the multilinear model is stored>'" << std::endl;
+                  << "Usage: './mlmviewer <directory name where the multilinear model is stored> [<further model directories>] [-m <memory budget in MB>]'" << std::endl;
         return EXIT_FAILURE;
     }
 
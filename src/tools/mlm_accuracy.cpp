@@ -0,0 +1,315 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "MultilinearModel.h"
+#include "Profiler.h"
+#include "EvaluationCache.h"
+#include "utils.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+//=============================================================================
+
+//! wall clock time in seconds
+static double now()
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+//-----------------------------------------------------------------------------
+
+//! an evaluation backend: evaluates all parameter sets (columns of wSkull
+//! and wFstt) into the columns of 'points'
+struct Backend
+{
+    std::string name;
+    bool single_precision;
+    std::function<void(const Eigen::MatrixXd&, const Eigen::MatrixXd&, Eigen::MatrixXd&)> evaluate;
+};
+
+//-----------------------------------------------------------------------------
+
+//! straightforward evaluation with extended precision accumulation, serving
+//! as reference for all backends
+static void evaluate_reference(const MultilinearModel& mlm,
+                               const Eigen::VectorXd& w_skull, const Eigen::VectorXd& w_fstt,
+                               Eigen::VectorXd& points)
+{
+    points.resize(mlm.dim0());
+#pragma omp parallel for
+    for (int i=0; i<(int)mlm.dim0(); ++i)
+    {
+        long double c = mlm.mean()[i];
+        for (unsigned int j=0; j<mlm.dim1(); ++j)
+            for (unsigned int k=0; k<mlm.dim2(); ++k)
+                c += (long double)mlm.tensor_entry(i,j,k) * w_skull(j) * w_fstt(k);
+        points(i) = double(c);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+static void usage()
+{
+    std::cerr << "Usage: mlm_accuracy <model directory> [options]\n"
+              << "  -w <fit dir>   add fitted parameters w_skull.scalars and w_fstt.scalars\n"
+              << "                 (default: the demo fits of the model directory)\n"
+              << "  -n <samples>   number of additional random parameter sets (default 8)\n"
+              << "  -r <reps>      timing repetitions (default 5)\n"
+              << "  -t <tol>       max. per-vertex error of double backends (default 1e-9)\n"
+              << "  -f <tol>       max. per-vertex error of float backends (default 1e-3)\n"
+              << "  -c <tol>       relative skull change for reusing cached contractions (default 1e-3)\n"
+              << "  -p <file>      write per-stage timings as JSON\n"
+              << "Exits with failure if any backend exceeds its tolerance.\n";
+}
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    const std::string dir = argv[1];
+    std::vector<std::string> fits;
+    unsigned int n_random    = 8;
+    unsigned int repetitions = 5;
+    double tolerance         = 1e-9;
+    double tolerance_float   = 1e-3;
+    double cache_tolerance   = 1e-3;
+    std::string profile;
+
+    for (int i=2; i<argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (i+1 >= argc)
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+        if      (arg == "-w") fits.push_back(argv[++i]);
+        else if (arg == "-n") n_random        = std::atoi(argv[++i]);
+        else if (arg == "-r") repetitions     = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "-t") tolerance       = std::atof(argv[++i]);
+        else if (arg == "-f") tolerance_float = std::atof(argv[++i]);
+        else if (arg == "-c") cache_tolerance = std::atof(argv[++i]);
+        else if (arg == "-p") profile         = argv[++i];
+        else
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+
+    // load model
+    MultilinearModel mlm;
+    if (!mlm.load_means(dir + "skin.off", dir + "skull.off") || !mlm.load(dir))
+    {
+        std::cerr << "[ERROR] Can't load multilinear model!" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const unsigned int dim0 = mlm.dim0(), dim1 = mlm.dim1(), dim2 = mlm.dim2();
+
+
+    // fixed parameter sets: mean, demo fits, seeded random samples
+    if (fits.empty())
+    {
+        for (const char* demo : { "mlm_fits2skull", "mlm_fits2skin" })
+            if (access((dir + demo + "/w_skull.scalars").c_str(), R_OK) == 0)
+                fits.push_back(dir + demo);
+    }
+
+    std::vector<Eigen::VectorXd> ws, wf;
+    std::vector<std::string> labels;
+    ws.push_back(mlm.U_skull().colwise().mean().transpose());
+    wf.push_back(mlm.U_fstt().colwise().mean().transpose());
+    labels.push_back("mean");
+
+    for (const std::string& fit : fits)
+    {
+        Eigen::VectorXd w_skull(dim1), w_fstt(dim2);
+        if (!load_parameters(w_skull, w_fstt, fit + "/w_skull.scalars", fit + "/w_fstt.scalars"))
+            return EXIT_FAILURE;
+        ws.push_back(w_skull);
+        wf.push_back(w_fstt);
+        labels.push_back(fit);
+    }
+
+    std::mt19937 rng(0);
+    for (unsigned int s=0; s<n_random; ++s)
+    {
+        const Eigen::MatrixXd& Us = mlm.U_skull();
+        const Eigen::MatrixXd& Uf = mlm.U_fstt();
+        std::uniform_int_distribution<int> row_s(0, Us.rows()-1), row_f(0, Uf.rows()-1);
+        std::normal_distribution<double> normal(0.0, 0.5);
+
+        // perturbed training subjects. every second set keeps the skull of
+        // the previous one, such that cached skull contractions are used.
+        Eigen::VectorXd w_skull = Us.row(row_s(rng)).transpose();
+        Eigen::VectorXd w_fstt  = Uf.row(row_f(rng)).transpose();
+        for (unsigned int j=0; j<dim1; ++j) w_skull(j) += normal(rng) * Us.col(j).norm() / std::sqrt(double(Us.rows()));
+        if (s % 2) w_skull = ws.back();
+        for (unsigned int k=0; k<dim2; ++k) w_fstt(k)  += normal(rng) * Uf.col(k).norm() / std::sqrt(double(Uf.rows()));
+        ws.push_back(w_skull);
+        wf.push_back(w_fstt);
+        labels.push_back("random" + std::to_string(s));
+    }
+
+    const unsigned int n = ws.size();
+    Eigen::MatrixXd WS(dim1, n), WF(dim2, n), reference(dim0, n);
+    for (unsigned int s=0; s<n; ++s)
+    {
+        WS.col(s) = ws[s];
+        WF.col(s) = wf[s];
+        Eigen::VectorXd p;
+        evaluate_reference(mlm, ws[s], wf[s], p);
+        reference.col(s) = p;
+    }
+
+
+    // all evaluation paths of the library
+    std::vector<unsigned int> all_rows(dim0);
+    for (unsigned int i=0; i<dim0; ++i) all_rows[i] = i;
+
+    std::vector<Backend> backends;
+    backends.push_back({ "evaluate", false,
+        [&](const Eigen::MatrixXd& S, const Eigen::MatrixXd& F, Eigen::MatrixXd& P)
+        {
+            Eigen::VectorXd p;
+            for (int s=0; s<S.cols(); ++s)
+            {
+                mlm.evaluate(p, S.col(s), F.col(s));
+                P.col(s) = p;
+            }
+        }});
+    backends.push_back({ "evaluate_batch", false,
+        [&](const Eigen::MatrixXd& S, const Eigen::MatrixXd& F, Eigen::MatrixXd& P)
+        {
+            mlm.evaluate_batch(P, S, F);
+        }});
+    backends.push_back({ "evaluate_rows", false,
+        [&](const Eigen::MatrixXd& S, const Eigen::MatrixXd& F, Eigen::MatrixXd& P)
+        {
+            Eigen::VectorXd p;
+            for (int s=0; s<S.cols(); ++s)
+            {
+                mlm.evaluate_rows(p, all_rows, S.col(s), F.col(s));
+                P.col(s) = p;
+            }
+        }});
+    backends.push_back({ "contract_skull", false,
+        [&](const Eigen::MatrixXd& S, const Eigen::MatrixXd& F, Eigen::MatrixXd& P)
+        {
+            // contract once per skull, as the viewer does while dragging
+            Eigen::MatrixXd contracted;
+            Eigen::VectorXd p;
+            for (int s=0; s<S.cols(); ++s)
+            {
+                if (s == 0 || S.col(s) != S.col(s-1))
+                    mlm.contract_skull(contracted, S.col(s));
+                mlm.evaluate_contracted(p, contracted, F.col(s));
+                P.col(s) = p;
+            }
+        }});
+    for (double cache_tol : { 0.0, cache_tolerance })
+    {
+        // the fitter's caching layer. with a nonzero tolerance, skull
+        // parameters closer than that reuse the previous contraction.
+        char name[64];
+        std::snprintf(name, sizeof(name), "EvaluationCache(%g)", cache_tol);
+        backends.push_back({ name, false,
+            [&mlm, cache_tol](const Eigen::MatrixXd& S, const Eigen::MatrixXd& F, Eigen::MatrixXd& P)
+            {
+                EvaluationCache cache(mlm);
+                cache.set_tolerance(cache_tol);
+                for (int s=0; s<S.cols(); ++s)
+                    P.col(s) = cache.evaluate(S.col(s), F.col(s));
+            }});
+    }
+    backends.push_back({ "evaluate_into<double>", false,
+        [&](const Eigen::MatrixXd& S, const Eigen::MatrixXd& F, Eigen::MatrixXd& P)
+        {
+            mlm.evaluate_into(P.data(), S.data(), F.data(), S.cols());
+        }});
+    backends.push_back({ "evaluate_into<float>", true,
+        [&](const Eigen::MatrixXd& S, const Eigen::MatrixXd& F, Eigen::MatrixXd& P)
+        {
+            std::vector<float> buffer(size_t(dim0) * S.cols());
+            mlm.evaluate_into(buffer.data(), S.data(), F.data(), S.cols());
+            P = Eigen::Map<Eigen::MatrixXf>(buffer.data(), dim0, S.cols()).cast<double>();
+        }});
+
+
+    // compare against reference, time each backend
+    bool ok = true;
+    std::printf("%-24s %14s %14s %12s %10s\n", "backend", "max_error", "rms_error", "ms/sample", "status");
+    for (const Backend& b : backends)
+    {
+        Eigen::MatrixXd points(dim0, n);
+        b.evaluate(WS, WF, points);
+
+        // per-vertex error: Euclidean distance to the reference position.
+        // column s*n_vertices+v of the 3 x (n_vertices*n) view is vertex v of
+        // parameter set s.
+        const unsigned int n_vertices = dim0 / 3;
+        const Eigen::MatrixXd difference = points - reference;
+        const Eigen::RowVectorXd error =
+            Eigen::Map<const Eigen::MatrixXd>(difference.data(), 3, size_t(n_vertices)*n).colwise().norm();
+        int worst;
+        const double max_error = error.maxCoeff(&worst);
+        const double rms_error = std::sqrt(error.squaredNorm() / error.size());
+
+        double best = 1e30;
+        for (unsigned int r=0; r<repetitions; ++r)
+        {
+            const double t0 = now();
+            b.evaluate(WS, WF, points);
+            best = std::min(best, now() - t0);
+        }
+
+        const double tol  = b.single_precision ? tolerance_float : tolerance;
+        const bool   pass = (max_error <= tol);
+        ok = ok && pass;
+
+        std::printf("%-24s %14.3e %14.3e %12.3f %10s\n", b.name.c_str(),
+                    max_error, rms_error, 1000.0 * best / n, pass ? "ok" : "FAILED");
+
+        // report the worst parameter set on failure
+        if (!pass)
+        {
+            std::printf("  worst parameter set: %s, vertex %u\n",
+                        labels[worst / n_vertices].c_str(), worst % n_vertices);
+        }
+    }
+
+    if (!profile.empty())
+        Profiler::instance().write_json(profile);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//=============================================================================
@@ -0,0 +1,342 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "MultilinearModel.h"
+#include "MeshExporter.h"
+#include "Profiler.h"
+
+#include <pmp/algorithms/SurfaceNormals.h>
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+//=============================================================================
+
+//! wall clock time in seconds
+static double now()
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+//-----------------------------------------------------------------------------
+
+//! timings of one benchmark, written as one JSON object
+struct Result
+{
+    std::string name;
+    int threads;
+    unsigned int items;            // items (evaluations, meshes) per repetition
+    double bytes;                  // tensor bytes streamed per repetition
+    std::vector<double> seconds;   // time per repetition
+
+    std::string json() const
+    {
+        std::vector<double> t = seconds;
+        std::sort(t.begin(), t.end());
+        double mean = 0.0;
+        for (double s : t) mean += s;
+        mean /= t.size();
+        const double median = t[t.size()/2];
+
+        std::ostringstream s;
+        s << "{\"name\": \"" << name << "\""
+          << ", \"threads\": " << threads
+          << ", \"repetitions\": " << t.size()
+          << ", \"min_s\": " << t.front()
+          << ", \"median_s\": " << median
+          << ", \"mean_s\": " << mean
+          << ", \"max_s\": " << t.back();
+        if (items)
+            s << ", \"items_per_s\": " << items / median;
+        if (bytes > 0.0)
+            s << ", \"gb_per_s\": " << bytes / median * 1e-9;
+        s << "}";
+        return s.str();
+    }
+};
+
+//-----------------------------------------------------------------------------
+
+//! drop the model files from the page cache, so the next load reads from disk
+static void evict_from_cache(const std::string& dir)
+{
+    const char* files[] = { "skin.off", "skull.off", "mlm_tensor.tensor",
+                            "matrix_U_skull.matrix", "matrix_U_fstt.matrix",
+                            "eigenvalues_skull.vector", "eigenvalues_fstt.vector" };
+    for (const char* f : files)
+    {
+        const int fd = open((dir + f).c_str(), O_RDONLY);
+        if (fd < 0) continue;
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+//! thread counts to benchmark: 1, 2, 4, ... and the maximum
+static std::vector<int> thread_counts()
+{
+    std::vector<int> counts;
+#ifdef _OPENMP
+    const int max_threads = omp_get_max_threads();
+#else
+    const int max_threads = 1;
+#endif
+    for (int n=1; n<max_threads; n*=2)
+        counts.push_back(n);
+    counts.push_back(max_threads);
+    return counts;
+}
+
+//-----------------------------------------------------------------------------
+
+static void set_threads(int n)
+{
+#ifdef _OPENMP
+    omp_set_num_threads(n);
+#else
+    (void)n;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+static void usage()
+{
+    std::cerr << "Usage: mlm_bench <model directory> [options]\n"
+              << "  -r <repetitions>  repetitions per benchmark (default 10)\n"
+              << "  -b <batch size>   samples per batched evaluation (default 16)\n"
+              << "  -o <directory>    scratch directory for export benchmarks (default .)\n"
+              << "  -p <file>         write per-stage timings of all runs as JSON\n"
+              << "Writes one JSON document with all timings to stdout.\n";
+}
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    const std::string dir = argv[1];
+    unsigned int n_repetitions = 10;
+    unsigned int batch_size    = 16;
+    std::string scratch        = "./";
+    std::string profile;
+
+    for (int i=2; i<argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (i+1 >= argc)
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+        if      (arg == "-r") n_repetitions = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "-b") batch_size    = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "-o") scratch       = std::string(argv[++i]) + "/";
+        else if (arg == "-p") profile       = argv[++i];
+        else
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<Result> results;
+    const std::vector<int> threads = thread_counts();
+    const int max_threads = threads.back();
+
+
+    // load topology
+    pmp::SurfaceMesh skin, skull;
+    if (!(skin.read(dir + "skin.off") && skull.read(dir + "skull.off")))
+    {
+        std::cerr << "Cannot load skin and skull meshes\n";
+        return EXIT_FAILURE;
+    }
+
+
+    // cold and warm loading
+    MultilinearModel mlm;
+    {
+        Result cold = { "load_cold", max_threads, 1, 0.0, {} };
+        Result warm = { "load_warm", max_threads, 1, 0.0, {} };
+        for (unsigned int r=0; r<n_repetitions; ++r)
+        {
+            std::cerr << "." << std::flush;
+
+            evict_from_cache(dir);
+            double t0 = now();
+            if (!mlm.load_means(dir + "skin.off", dir + "skull.off") || !mlm.load(dir))
+            {
+                std::cerr << "[ERROR] Can't load multilinear model!" << std::endl;
+                return EXIT_FAILURE;
+            }
+            cold.seconds.push_back(now() - t0);
+
+            t0 = now();
+            mlm.load_means(dir + "skin.off", dir + "skull.off");
+            mlm.load(dir);
+            warm.seconds.push_back(now() - t0);
+        }
+        const double tensor_bytes = double(mlm.dim0()) * mlm.dim1() * mlm.dim2() * sizeof(double);
+        cold.bytes = warm.bytes = tensor_bytes;
+        results.push_back(cold);
+        results.push_back(warm);
+    }
+
+    const double tensor_bytes = double(mlm.dim0()) * mlm.dim1() * mlm.dim2() * sizeof(double);
+
+
+    // parameters: mean of the training parameters
+    const Eigen::VectorXd w_skull = mlm.U_skull().colwise().mean().transpose();
+    const Eigen::VectorXd w_fstt  = mlm.U_fstt().colwise().mean().transpose();
+    Eigen::VectorXd points;
+    Eigen::MatrixXd batch_points;
+    const Eigen::MatrixXd w_skull_batch = w_skull.replicate(1, batch_size);
+    const Eigen::MatrixXd w_fstt_batch  = w_fstt.replicate(1, batch_size);
+
+
+    // single and batched evaluation for different numbers of threads
+    for (int n : threads)
+    {
+        set_threads(n);
+
+        Result single = { "evaluate", n, 1, tensor_bytes, {} };
+        mlm.evaluate(points, w_skull, w_fstt); // warm-up
+        for (unsigned int r=0; r<n_repetitions; ++r)
+        {
+            const double t0 = now();
+            mlm.evaluate(points, w_skull, w_fstt);
+            single.seconds.push_back(now() - t0);
+        }
+        results.push_back(single);
+
+        Result batch = { "evaluate_batch", n, batch_size, tensor_bytes, {} };
+        mlm.evaluate_batch(batch_points, w_skull_batch, w_fstt_batch); // warm-up
+        for (unsigned int r=0; r<n_repetitions; ++r)
+        {
+            const double t0 = now();
+            mlm.evaluate_batch(batch_points, w_skull_batch, w_fstt_batch);
+            batch.seconds.push_back(now() - t0);
+        }
+        results.push_back(batch);
+
+        std::cerr << "." << std::flush;
+    }
+    set_threads(max_threads);
+
+
+    // normal re-computation, i.e., the CPU part of MLMViewer::update_meshes()
+    {
+        mlm.points_to_meshes(points, skin, skull);
+        Result normals = { "vertex_normals", 1, 2, 0.0, {} };
+        for (unsigned int r=0; r<n_repetitions; ++r)
+        {
+            const double t0 = now();
+            pmp::SurfaceNormals::compute_vertex_normals(skin);
+            pmp::SurfaceNormals::compute_vertex_normals(skull);
+            normals.seconds.push_back(now() - t0);
+        }
+        results.push_back(normals);
+        std::cerr << "." << std::flush;
+    }
+
+
+    // mesh export: write a batch of samples per repetition. the sample is
+    // evaluated once up front, so only the exporter is timed.
+    mlm.evaluate(points, w_skull, w_fstt);
+    const char* format_names[] = { "off", "ply", "stl", "raw" };
+    for (const char* name : format_names)
+    {
+        MeshExporter::Format format;
+        MeshExporter::parse_format(name, format);
+
+        MeshExporter exporter;
+        exporter.set_topology(skin, skull);
+        exporter.set_output(scratch + "mlm_bench_", format);
+
+        Result result = { std::string("export_") + name, max_threads, batch_size, 0.0, {} };
+        for (unsigned int r=0; r<n_repetitions; ++r)
+        {
+            const double t0 = now();
+            for (unsigned int s=0; s<batch_size; ++s)
+                exporter.enqueue(points, s);
+            exporter.finish();
+            result.seconds.push_back(now() - t0);
+        }
+        results.push_back(result);
+
+        if (exporter.n_failed())
+        {
+            std::cerr << "[ERROR] Can't write to " << scratch << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        // remove scratch files
+        const std::string ext = MeshExporter::extension(format);
+        for (unsigned int s=0; s<batch_size; ++s)
+        {
+            const std::string index = std::to_string(s);
+            if (format == MeshExporter::RAW_FLOAT32)
+            {
+                std::remove((scratch + "mlm_bench_" + index + ext).c_str());
+            }
+            else
+            {
+                std::remove((scratch + "mlm_bench_skin_"  + index + ext).c_str());
+                std::remove((scratch + "mlm_bench_skull_" + index + ext).c_str());
+            }
+        }
+        std::cerr << "." << std::flush;
+    }
+    std::cerr << std::endl;
+
+
+    // report
+    std::cout << "{\n"
+              << "  \"model\": {\"dim0\": " << mlm.dim0()
+              << ", \"dim1\": " << mlm.dim1()
+              << ", \"dim2\": " << mlm.dim2()
+              << ", \"tensor_bytes\": " << tensor_bytes << "},\n"
+              << "  \"benchmarks\": [\n";
+    for (unsigned int i=0; i<results.size(); ++i)
+    {
+        std::cout << "    " << results[i].json()
+                  << (i+1 < results.size() ? ",\n" : "\n");
+    }
+    std::cout << "  ]\n}" << std::endl;
+
+    if (!profile.empty())
+        Profiler::instance().write_json(profile);
+
+    return EXIT_SUCCESS;
+}
+
+//=============================================================================
@@ -0,0 +1,213 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "MultilinearModel.h"
+#include "MeshExporter.h"
+#include "PenetrationChecker.h"
+#include "ThumbnailRenderer.h"
+#include "Profiler.h"
+
+#include <iostream>
+#include <random>
+#include <cstdlib>
+
+//=============================================================================
+
+//! normal distribution per parameter, fitted to the rows of a mode matrix
+struct ParameterDistribution
+{
+    //! fit mean and standard deviation of each column of \c U
+    explicit ParameterDistribution(const Eigen::MatrixXd& U)
+    {
+        mean   = U.colwise().mean();
+        stddev = ((U.rowwise() - mean).colwise().squaredNorm() / U.rows()).cwiseSqrt();
+    }
+
+    //! draw parameters component-wise
+    void sample(std::mt19937& rng, Eigen::VectorXd& w) const
+    {
+        w.resize(mean.size());
+        for (int j=0; j<mean.size(); ++j)
+        {
+            std::normal_distribution<double> normal(mean(j), stddev(j));
+            w(j) = normal(rng);
+        }
+    }
+
+    Eigen::RowVectorXd mean, stddev;
+};
+
+//-----------------------------------------------------------------------------
+
+static void usage()
+{
+    std::cerr << "Usage: mlm_export <model directory> <output prefix> [options]\n"
+              << "  -n <samples>   number of random samples (default 1)\n"
+              << "  -f <format>    off | ply | stl | raw (default ply)\n"
+              << "  -t <threads>   number of I/O threads (default 2)\n"
+              << "  -s <seed>      random seed (default 0)\n"
+              << "  -v <distance>  reject samples with skin closer to the skull than <distance>\n"
+              << "  -m <score>     accepted fraction of such skin vertices (default 0)\n"
+              << "  -i <size>      also render <prefix>thumb_<index>.png of size x size pixels\n"
+              << "  -p <file>      write per-stage timings as JSON\n";
+}
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    const std::string dir    = argv[1];
+    const std::string prefix = argv[2];
+    unsigned int n_samples = 1;
+    unsigned int n_threads = 2;
+    unsigned int seed      = 0;
+    double min_thickness = -1.0;
+    double max_score     = 0.0;
+    unsigned int thumbnail_size = 0;
+    std::string profile;
+    MeshExporter::Format format = MeshExporter::PLY_BINARY;
+
+    for (int i=3; i<argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (i+1 >= argc)
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+        if      (arg == "-n") n_samples = std::atoi(argv[++i]);
+        else if (arg == "-t") n_threads = std::atoi(argv[++i]);
+        else if (arg == "-s") seed      = std::atoi(argv[++i]);
+        else if (arg == "-v") min_thickness = std::atof(argv[++i]);
+        else if (arg == "-m") max_score     = std::atof(argv[++i]);
+        else if (arg == "-i") thumbnail_size = std::atoi(argv[++i]);
+        else if (arg == "-p") profile   = argv[++i];
+        else if (arg == "-f")
+        {
+            if (!MeshExporter::parse_format(argv[++i], format))
+            {
+                usage();
+                return EXIT_FAILURE;
+            }
+        }
+        else
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+
+    // load topology and model
+    pmp::SurfaceMesh skin, skull;
+    if (!(skin.read(dir + "skin.off") && skull.read(dir + "skull.off")))
+    {
+        std::cerr << "Cannot load skin and skull meshes\n";
+        return EXIT_FAILURE;
+    }
+
+    MultilinearModel mlm;
+    if (!mlm.load_means(dir + "skin.off", dir + "skull.off") || !mlm.load(dir))
+    {
+        std::cerr << "[ERROR] Can't load multilinear model!" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+
+    // setup exporter
+    MeshExporter exporter(n_threads);
+    if (!exporter.set_topology(skin, skull))
+        return EXIT_FAILURE;
+    exporter.set_output(prefix, format);
+    if (format == MeshExporter::RAW_FLOAT32 &&
+        !exporter.write_topology(prefix + "topology.bin"))
+        return EXIT_FAILURE;
+
+
+    // setup validation
+    PenetrationChecker checker;
+    const bool validate = (min_thickness >= 0.0);
+    if (validate)
+    {
+        if (!checker.set_topology(skin, skull))
+            return EXIT_FAILURE;
+        checker.set_threshold(min_thickness);
+    }
+
+
+    // setup thumbnails, viewed as the mean head
+    ThumbnailRenderer renderer(thumbnail_size, thumbnail_size);
+    if (thumbnail_size)
+    {
+        if (!renderer.set_topology(skin, skull))
+            return EXIT_FAILURE;
+        if (!renderer.load_matcaps(dir + "matcap-skin.jpg", dir + "matcap-bone.jpg"))
+            std::cerr << "Using diffuse shading for thumbnails\n";
+        renderer.set_view(Eigen::Map<const Eigen::VectorXd>(mlm.mean().data(), mlm.dim0()));
+    }
+
+
+    // evaluate samples, writing happens in the background. implausible
+    // samples are rejected and redrawn, up to a fixed number of attempts.
+    std::mt19937 rng(seed);
+    const ParameterDistribution skull_distribution(mlm.U_skull());
+    const ParameterDistribution fstt_distribution(mlm.U_fstt());
+    Eigen::VectorXd w_skull, w_fstt, points;
+    const unsigned int max_attempts = 10*n_samples + 100;
+    unsigned int n_accepted = 0, n_rejected = 0;
+    while (n_accepted < n_samples && n_accepted + n_rejected < max_attempts)
+    {
+        skull_distribution.sample(rng, w_skull);
+        fstt_distribution.sample(rng, w_fstt);
+        mlm.evaluate(points, w_skull, w_fstt);
+
+        if (validate && checker.check(points).score > max_score)
+        {
+            ++n_rejected;
+            continue;
+        }
+
+        if (thumbnail_size)
+        {
+            renderer.render(points);
+            renderer.write_png(prefix + "thumb_" + std::to_string(n_accepted) + ".png");
+        }
+
+        exporter.enqueue(points, n_accepted++);
+    }
+    exporter.finish();
+
+
+    if (validate)
+        std::cout << "Rejected " << n_rejected << " implausible samples\n";
+    if (n_accepted < n_samples)
+        std::cerr << "Only " << n_accepted << " of " << n_samples
+                  << " samples passed validation\n";
+
+    std::cout << "Wrote " << exporter.n_written() << " samples";
+    if (exporter.n_failed())
+        std::cout << ", " << exporter.n_failed() << " failed";
+    std::cout << std::endl;
+
+    if (!profile.empty())
+        Profiler::instance().write_json(profile);
+
+    return exporter.n_failed() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+//=============================================================================
@@ -0,0 +1,165 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "MultilinearModel.h"
+#include "ModelFitter.h"
+#include "PointCloudIO.h"
+#include "Profiler.h"
+#include "utils.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+
+//=============================================================================
+
+static void usage()
+{
+    std::cerr << "Usage: mlm_fit <model directory> <target points> <output directory> [options]\n"
+              << "  -s <part>      fit skin | skull (default skull)\n"
+              << "  -i <iters>     maximum number of Gauss-Newton iterations (default 20)\n"
+              << "  -t <tol>       relative skull parameter change below which the contraction is reused (default 0)\n"
+              << "  -c <dist>      vertex motion below which correspondences are reused (default 0)\n"
+              << "  -d <step>      use every step-th vertex (default 4)\n"
+              << "  -r <weight>    regularization weight (default 0.01)\n"
+              << "  -p <file>      write stage timings and counters as JSON\n"
+              << "Starts from the mean parameters and writes w_skull.scalars and\n"
+              << "w_fstt.scalars to the output directory.\n";
+}
+
+//-----------------------------------------------------------------------------
+
+static bool write_scalars(const Eigen::VectorXd& values, const std::string& filename)
+{
+    std::ofstream ofs(filename);
+    ofs.precision(17);
+    for (int i=0; i<values.size(); ++i)
+        ofs << values(i) << "\n";
+    ofs.close();
+    if (ofs.fail())
+    {
+        std::cerr << "[ERROR] Can't write " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    const std::string dir    = argv[1];
+    const std::string target = argv[2];
+    const std::string output = argv[3];
+    ModelFitter::Part part   = ModelFitter::SKULL;
+    unsigned int iterations  = 20;
+    unsigned int step        = 4;
+    double param_tolerance   = 0.0;
+    double corr_tolerance    = 0.0;
+    double regularization    = 0.01;
+    std::string profile;
+
+    for (int i=4; i<argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (i+1 >= argc)
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+        if      (arg == "-i") iterations      = std::atoi(argv[++i]);
+        else if (arg == "-t") param_tolerance = std::atof(argv[++i]);
+        else if (arg == "-c") corr_tolerance  = std::atof(argv[++i]);
+        else if (arg == "-d") step            = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "-r") regularization  = std::atof(argv[++i]);
+        else if (arg == "-p") profile         = argv[++i];
+        else if (arg == "-s")
+        {
+            const std::string p = argv[++i];
+            if      (p == "skin")  part = ModelFitter::SKIN;
+            else if (p == "skull") part = ModelFitter::SKULL;
+            else
+            {
+                usage();
+                return EXIT_FAILURE;
+            }
+        }
+        else
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+
+    // load model and target
+    MultilinearModel mlm;
+    if (!mlm.load_means(dir + "skin.off", dir + "skull.off") || !mlm.load(dir))
+    {
+        std::cerr << "[ERROR] Can't load multilinear model!" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<float> points;
+    if (!read_points(target, points) || points.empty())
+    {
+        std::cerr << "[ERROR] Can't load target points from " << target << std::endl;
+        return EXIT_FAILURE;
+    }
+
+
+    // create the output directory before the (possibly long) fit
+    if (!make_directory(output))
+        return EXIT_FAILURE;
+
+
+    // fit, starting from the mean parameters
+    ModelFitter fitter(mlm);
+    fitter.set_part(part);
+    fitter.set_subsampling(step);
+    fitter.set_parameter_tolerance(param_tolerance);
+    fitter.set_correspondence_tolerance(corr_tolerance);
+    fitter.set_regularization(regularization);
+    fitter.set_target(points);
+
+    Eigen::VectorXd w_skull = mlm.U_skull().colwise().mean().transpose();
+    Eigen::VectorXd w_fstt  = mlm.U_fstt().colwise().mean().transpose();
+
+    const double rms = fitter.fit(w_skull, w_fstt, iterations);
+    if (rms < 0.0)
+        return EXIT_FAILURE;
+
+
+    // report
+    const EvaluationCache::Counters& cc = fitter.cache().counters();
+    const ModelFitter::Counters& fc = fitter.counters();
+    std::printf("Fitted %u target points, RMS distance %g\n", unsigned(points.size()/3), rms);
+    std::printf("  contraction:     %lu hits, %lu misses\n", cc.contraction_hits, cc.contraction_misses);
+    std::printf("  correspondences: %lu hits, %lu misses\n", fc.correspondence_hits, fc.correspondence_misses);
+
+    if (!profile.empty())
+        Profiler::instance().write_json(profile);
+
+    const bool ok = write_scalars(w_skull, output + "/w_skull.scalars") &&
+                    write_scalars(w_fstt,  output + "/w_fstt.scalars");
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//=============================================================================
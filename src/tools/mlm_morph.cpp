@@ -0,0 +1,139 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "MultilinearModel.h"
+#include "MorphSequence.h"
+#include "MeshExporter.h"
+#include "Profiler.h"
+#include "utils.h"
+
+#include <iostream>
+#include <cstdlib>
+
+//=============================================================================
+
+static void usage()
+{
+    std::cerr << "Usage: mlm_morph <model directory> <output prefix> <fit directory> [<frames> <fit directory>]... [options]\n"
+              << "  each fit directory contains w_skull.scalars and w_fstt.scalars\n"
+              << "  -f <format>    off | ply | stl | raw (default ply)\n"
+              << "  -t <threads>   number of I/O threads (default 2)\n"
+              << "  -p <file>      write per-stage timings as JSON\n";
+}
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    const std::string dir    = argv[1];
+    const std::string prefix = argv[2];
+    unsigned int n_threads = 2;
+    std::string profile;
+    MeshExporter::Format format = MeshExporter::PLY_BINARY;
+
+
+    // split keyframe arguments from options
+    std::vector<std::string> keys;
+    for (int i=3; i<argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "-f" && i+1 < argc)
+        {
+            if (!MeshExporter::parse_format(argv[++i], format))
+            {
+                usage();
+                return EXIT_FAILURE;
+            }
+        }
+        else if (arg == "-t" && i+1 < argc)
+        {
+            n_threads = std::atoi(argv[++i]);
+        }
+        else if (arg == "-p" && i+1 < argc)
+        {
+            profile = argv[++i];
+        }
+        else
+        {
+            keys.push_back(arg);
+        }
+    }
+    if (keys.size() % 2 == 0)
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+
+    // load topology and model
+    pmp::SurfaceMesh skin, skull;
+    if (!(skin.read(dir + "skin.off") && skull.read(dir + "skull.off")))
+    {
+        std::cerr << "Cannot load skin and skull meshes\n";
+        return EXIT_FAILURE;
+    }
+
+    MultilinearModel mlm;
+    if (!mlm.load_means(dir + "skin.off", dir + "skull.off") || !mlm.load(dir))
+    {
+        std::cerr << "[ERROR] Can't load multilinear model!" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+
+    // setup keyframes
+    MorphSequence sequence(mlm);
+    Eigen::VectorXd w_skull(mlm.dim1()), w_fstt(mlm.dim2());
+    for (unsigned int i=0; i<keys.size(); i+=2)
+    {
+        const unsigned int n_frames = (i == 0) ? 0 : std::atoi(keys[i-1].c_str());
+        if (!load_parameters(w_skull, w_fstt,
+                             keys[i] + "/w_skull.scalars",
+                             keys[i] + "/w_fstt.scalars"))
+        {
+            std::cerr << "Cannot load parameters from " << keys[i] << std::endl;
+            return EXIT_FAILURE;
+        }
+        sequence.add_keyframe(w_skull, w_fstt, n_frames);
+    }
+
+
+    // generate frames, writing happens in the background
+    MeshExporter exporter(n_threads);
+    if (!exporter.set_topology(skin, skull))
+        return EXIT_FAILURE;
+    exporter.set_output(prefix, format);
+    if (format == MeshExporter::RAW_FLOAT32 &&
+        !exporter.write_topology(prefix + "topology.bin"))
+        return EXIT_FAILURE;
+
+    if (!sequence.generate(exporter))
+        return EXIT_FAILURE;
+    exporter.finish();
+
+
+    std::cout << "Wrote " << exporter.n_written() << " of "
+              << sequence.n_frames() << " frames" << std::endl;
+
+    if (!profile.empty())
+        Profiler::instance().write_json(profile);
+
+    return exporter.n_failed() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+//=============================================================================
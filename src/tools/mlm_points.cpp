@@ -0,0 +1,42 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "PointCloudIO.h"
+
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+
+//=============================================================================
+
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        std::cerr << "Usage: mlm_points <input .xyz/.bxyz> <output .bxyz>\n"
+                  << "Converts a point set to the binary point set format.\n";
+        return EXIT_FAILURE;
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<float> points;
+    if (!read_points(argv[1], points))
+        return EXIT_FAILURE;
+    const std::chrono::duration<double> t = std::chrono::steady_clock::now() - t0;
+
+    std::cout << "Read " << points.size()/3 << " points in "
+              << 1000.0 * t.count() << " ms" << std::endl;
+
+    return write_binary_points(argv[2], points) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//=============================================================================
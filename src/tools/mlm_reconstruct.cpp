@@ -0,0 +1,141 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "MultilinearModel.h"
+#include "SkinReconstruction.h"
+#include "MeshExporter.h"
+#include "utils.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+
+//=============================================================================
+
+static void usage()
+{
+    std::cerr << "Usage: mlm_reconstruct <model directory> <w_skull.scalars> <output prefix> [options]\n"
+              << "  -k <variants>  number of skin variants drawn from the FSTT prior (default 0)\n"
+              << "  -s <seed>      random seed (default 0)\n"
+              << "  -f <format>    off | ply | stl | raw (default ply)\n"
+              << "Writes the expected head as sample 0, variants as samples 1..k, and the\n"
+              << "standard deviation of each skin vertex to <prefix>skin_stddev.scalars.\n";
+}
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    const std::string dir    = argv[1];
+    const std::string params = argv[2];
+    const std::string prefix = argv[3];
+    unsigned int n_variants = 0;
+    unsigned int seed       = 0;
+    MeshExporter::Format format = MeshExporter::PLY_BINARY;
+
+    for (int i=4; i<argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (i+1 >= argc)
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+        if      (arg == "-k") n_variants = std::atoi(argv[++i]);
+        else if (arg == "-s") seed       = std::atoi(argv[++i]);
+        else if (arg == "-f")
+        {
+            if (!MeshExporter::parse_format(argv[++i], format))
+            {
+                usage();
+                return EXIT_FAILURE;
+            }
+        }
+        else
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+
+    // load topology and model
+    pmp::SurfaceMesh skin, skull;
+    if (!(skin.read(dir + "skin.off") && skull.read(dir + "skull.off")))
+    {
+        std::cerr << "Cannot load skin and skull meshes\n";
+        return EXIT_FAILURE;
+    }
+
+    MultilinearModel mlm;
+    if (!mlm.load_means(dir + "skin.off", dir + "skull.off") || !mlm.load(dir))
+    {
+        std::cerr << "[ERROR] Can't load multilinear model!" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+
+    // fitted skull parameters
+    std::vector<double> values;
+    if (!load_scalars(values, params) || values.size() < mlm.dim1())
+    {
+        std::cerr << "[ERROR] Can't load " << mlm.dim1() << " skull parameters from " << params << std::endl;
+        return EXIT_FAILURE;
+    }
+    const Eigen::VectorXd w_skull = Eigen::Map<const Eigen::VectorXd>(values.data(), mlm.dim1());
+
+
+    // reconstruct: contract skull once, then expectation and variants
+    SkinReconstruction reconstruction(mlm);
+    reconstruction.set_skull(w_skull);
+
+    MeshExporter exporter;
+    if (!exporter.set_topology(skin, skull))
+        return EXIT_FAILURE;
+    exporter.set_output(prefix, format);
+    if (format == MeshExporter::RAW_FLOAT32 &&
+        !exporter.write_topology(prefix + "topology.bin"))
+        return EXIT_FAILURE;
+
+    Eigen::VectorXd points;
+    reconstruction.expected(points);
+    exporter.enqueue(points, 0);
+
+    if (n_variants)
+    {
+        Eigen::MatrixXd variants;
+        reconstruction.sample(variants, n_variants, seed);
+        for (unsigned int s=0; s<n_variants; ++s)
+            exporter.enqueue(variants.col(s), s+1);
+    }
+
+
+    // per-vertex uncertainty of the skin
+    Eigen::VectorXd stddev;
+    reconstruction.skin_stddev(stddev);
+    std::ofstream ofs(prefix + "skin_stddev.scalars");
+    for (int v=0; v<stddev.size(); ++v)
+        ofs << stddev(v) << "\n";
+    ofs.close();
+
+    exporter.finish();
+
+    return (exporter.n_failed() || ofs.fail()) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+//=============================================================================
@@ -0,0 +1,151 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "MultilinearModel.h"
+#include "RegionMap.h"
+#include "RegionEvaluator.h"
+#include "Profiler.h"
+#include "utils.h"
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+
+//=============================================================================
+
+static void usage()
+{
+    std::cerr << "Usage: mlm_regions <model directory> <skin labels> <skull labels> [options]\n"
+              << "  -n <file>      region names, lines \"<label> <name>\"\n"
+              << "  -r <region>    restrict to region (label or name), may be repeated\n"
+              << "  -w <fit dir>   parameters w_skull.scalars and w_fstt.scalars (default: mean)\n"
+              << "  -m <margin>    margin of the skull neighborhood for thickness (default 10)\n"
+              << "  -p <file>      write per-stage timings as JSON\n"
+              << "Label files contain one integer per vertex, -1 for unlabeled vertices.\n";
+}
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    const std::string dir          = argv[1];
+    const std::string skin_labels  = argv[2];
+    const std::string skull_labels = argv[3];
+    std::string names, fit, profile;
+    std::vector<std::string> selection;
+    double margin = 10.0;
+
+    for (int i=4; i<argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (i+1 >= argc)
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+        if      (arg == "-n") names   = argv[++i];
+        else if (arg == "-r") selection.push_back(argv[++i]);
+        else if (arg == "-w") fit     = argv[++i];
+        else if (arg == "-m") margin  = std::atof(argv[++i]);
+        else if (arg == "-p") profile = argv[++i];
+        else
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+
+    // load topology and model
+    pmp::SurfaceMesh skin, skull;
+    if (!(skin.read(dir + "skin.off") && skull.read(dir + "skull.off")))
+    {
+        std::cerr << "Cannot load skin and skull meshes\n";
+        return EXIT_FAILURE;
+    }
+
+    MultilinearModel mlm;
+    if (!mlm.load_means(dir + "skin.off", dir + "skull.off") || !mlm.load(dir))
+    {
+        std::cerr << "[ERROR] Can't load multilinear model!" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+
+    // load regions
+    RegionMap regions;
+    if (!regions.load(skin_labels, skull_labels, skin.n_vertices(), skull.n_vertices()))
+        return EXIT_FAILURE;
+    if (!names.empty() && !regions.load_names(names))
+        return EXIT_FAILURE;
+
+    std::vector<int> labels;
+    for (const std::string& s : selection)
+    {
+        int label = regions.label(s);
+        if (label < 0)
+        {
+            char* end;
+            label = std::strtol(s.c_str(), &end, 10);
+            if (*end || label < 0)
+            {
+                std::cerr << "Unknown region " << s << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        labels.push_back(label);
+    }
+    if (labels.empty())
+        labels = regions.labels();
+
+
+    // parameters: mean or fitted
+    Eigen::VectorXd w_skull = mlm.U_skull().colwise().mean().transpose();
+    Eigen::VectorXd w_fstt  = mlm.U_fstt().colwise().mean().transpose();
+    if (!fit.empty() &&
+        !load_parameters(w_skull, w_fstt, fit + "/w_skull.scalars", fit + "/w_fstt.scalars"))
+        return EXIT_FAILURE;
+
+
+    // evaluate selected regions only
+    RegionEvaluator evaluator(mlm);
+    evaluator.set_margin(margin);
+    if (!evaluator.select(regions, labels, skull))
+        return EXIT_FAILURE;
+
+    std::vector<RegionEvaluator::Statistics> stats;
+    evaluator.statistics(stats, w_skull, w_fstt);
+
+    std::printf("%-16s %8s %8s %12s %12s %12s %12s\n", "region", "skin", "skull",
+                "thickness", "thick_var", "displacement", "displ_var");
+    for (const auto& s : stats)
+    {
+        std::printf("%-16s %8u %8u %12.4f %12.4f %12.4f %12.4f\n",
+                    regions.name(s.label).c_str(), s.n_skin_vertices, s.n_skull_vertices,
+                    s.thickness_mean, s.thickness_variance,
+                    s.displacement_mean, s.displacement_variance);
+    }
+    std::printf("evaluated %zu of %u tensor rows\n", evaluator.statistics_rows().size(), mlm.dim0());
+
+    if (!profile.empty())
+        Profiler::instance().write_json(profile);
+
+    return EXIT_SUCCESS;
+}
+
+//=============================================================================
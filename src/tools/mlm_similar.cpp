@@ -0,0 +1,117 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "MultilinearModel.h"
+#include "FitIndex.h"
+#include "Profiler.h"
+#include "utils.h"
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+
+//=============================================================================
+
+static void usage()
+{
+    std::cerr << "Usage: mlm_similar <model directory> <query fit dir> <fit dir>... [options]\n"
+              << "  -k <n>         number of similar fits (default 5)\n"
+              << "  -c <n>         re-rank the n closest fits by vertex distance (default 0: off)\n"
+              << "  -p <file>      write per-stage timings as JSON\n"
+              << "Fit directories contain w_skull.scalars and w_fstt.scalars.\n";
+}
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    const std::string dir   = argv[1];
+    const std::string query = argv[2];
+    std::vector<std::string> fits;
+    unsigned int k            = 5;
+    unsigned int n_candidates = 0;
+    std::string profile;
+
+    for (int i=3; i<argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg[0] != '-')
+        {
+            fits.push_back(arg);
+            continue;
+        }
+        if (i+1 >= argc)
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+        if      (arg == "-k") k            = std::atoi(argv[++i]);
+        else if (arg == "-c") n_candidates = std::atoi(argv[++i]);
+        else if (arg == "-p") profile      = argv[++i];
+        else
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+
+    // load model
+    MultilinearModel mlm;
+    if (!mlm.load_means(dir + "skin.off", dir + "skull.off") || !mlm.load(dir))
+    {
+        std::cerr << "[ERROR] Can't load multilinear model!" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+
+    // index all fits
+    FitIndex index(mlm);
+    for (const std::string& fit : fits)
+        if (!index.add(fit))
+            std::cerr << "Skipping " << fit << std::endl;
+    index.build();
+
+    Eigen::VectorXd w_skull(mlm.dim1()), w_fstt(mlm.dim2());
+    if (!load_parameters(w_skull, w_fstt, query + "/w_skull.scalars", query + "/w_fstt.scalars"))
+        return EXIT_FAILURE;
+
+
+    // query
+    std::vector<FitIndex::Neighbor> neighbors;
+    if (n_candidates)
+        index.query_reranked(w_skull, w_fstt, k, n_candidates, neighbors);
+    else
+        index.query(w_skull, w_fstt, k, neighbors);
+
+    std::printf("%-40s %14s %14s\n", "fit", "param_dist", "vertex_rms");
+    for (const auto& n : neighbors)
+    {
+        std::printf("%-40s %14.6f", index.name(n.index).c_str(), n.distance);
+        if (n.vertex_distance >= 0.0)
+            std::printf(" %14.6f", n.vertex_distance);
+        std::printf("\n");
+    }
+
+    if (!profile.empty())
+        Profiler::instance().write_json(profile);
+
+    return EXIT_SUCCESS;
+}
+
+//=============================================================================
@@ -0,0 +1,266 @@
+//=============================================================================
+//
+//   Copyright (c) by Computer Graphics Group, Bielefeld University
+//
+// This work is licensed under a
+// Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+//
+// You should have received a copy of the license along with this
+// work. If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+//
+//=============================================================================
+
+#include "utils.h"
+
+#include <pmp/SurfaceMesh.h>
+
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+//=============================================================================
+
+//! triangulated ellipsoid with radii (a,b,c) and about \c n_vertices vertices
+static void ellipsoid(pmp::SurfaceMesh& mesh, unsigned int n_vertices,
+                      float a, float b, float c)
+{
+    using pmp::Vertex;
+    using pmp::Point;
+
+    // latitude/longitude grid with 2*n_lat segments per ring:
+    // 2*n_lat*(n_lat-1) + 2 vertices
+    const unsigned int n_lat = std::max(2u, (unsigned int)std::lround(
+                                   0.5 + std::sqrt(0.25 + 0.5*std::max(0.0, double(n_vertices) - 2.0))));
+    const unsigned int n_lon = 2*n_lat;
+
+    mesh.clear();
+    const Vertex north = mesh.add_vertex(Point(0, 0, c));
+    std::vector<Vertex> rings;
+    for (unsigned int i=1; i<n_lat; ++i)
+    {
+        const double theta = M_PI * i / n_lat;
+        for (unsigned int j=0; j<n_lon; ++j)
+        {
+            const double phi = 2.0 * M_PI * j / n_lon;
+            rings.push_back(mesh.add_vertex(Point(a * std::sin(theta) * std::cos(phi),
+                                                  b * std::sin(theta) * std::sin(phi),
+                                                  c * std::cos(theta))));
+        }
+    }
+    const Vertex south = mesh.add_vertex(Point(0, 0, -c));
+
+    for (unsigned int j=0; j<n_lon; ++j)
+    {
+        const unsigned int jj = (j+1) % n_lon;
+
+        mesh.add_triangle(north, rings[j], rings[jj]);
+
+        for (unsigned int i=0; i+2<n_lat; ++i)
+        {
+            const Vertex v00 = rings[i*n_lon + j],     v01 = rings[i*n_lon + jj];
+            const Vertex v10 = rings[(i+1)*n_lon + j], v11 = rings[(i+1)*n_lon + jj];
+            mesh.add_triangle(v00, v10, v11);
+            mesh.add_triangle(v00, v11, v01);
+        }
+
+        const unsigned int last = (n_lat-2)*n_lon;
+        mesh.add_triangle(south, rings[last + jj], rings[last + j]);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+//! random matrix with orthonormal columns, as the mode matrices U of the model
+static Eigen::MatrixXd random_mode_matrix(unsigned int rows, unsigned int cols,
+                                          std::mt19937& rng)
+{
+    std::normal_distribution<double> normal;
+    Eigen::MatrixXd A(rows, cols);
+    for (unsigned int j=0; j<cols; ++j)
+        for (unsigned int i=0; i<rows; ++i)
+            A(i,j) = normal(rng);
+
+    Eigen::HouseholderQR<Eigen::MatrixXd> qr(A);
+    return qr.householderQ() * Eigen::MatrixXd::Identity(rows, cols);
+}
+
+//-----------------------------------------------------------------------------
+
+//! decreasing positive eigenvalues
+static Eigen::VectorXd random_eigenvalues(unsigned int n, std::mt19937& rng)
+{
+    std::uniform_real_distribution<double> uniform(0.5, 1.0);
+    Eigen::VectorXd ev(n);
+    double lambda = 1.0;
+    for (unsigned int i=0; i<n; ++i)
+    {
+        ev(i) = lambda;
+        lambda *= uniform(rng);
+    }
+    return ev;
+}
+
+//-----------------------------------------------------------------------------
+
+//! write random tensor in the format read by MultilinearModel::load(). the
+//! tensor is generated in blocks of rows, so it never has to fit into memory.
+static bool write_tensor(const std::string& filename,
+                         unsigned int dim0, unsigned int dim1, unsigned int dim2,
+                         double amplitude, unsigned int seed)
+{
+    std::ofstream ofs(filename.c_str(), std::ofstream::binary);
+    if (!ofs.is_open())
+    {
+        std::cerr << "Cannot write tensor " << filename << std::endl;
+        return false;
+    }
+    ofs.write(reinterpret_cast<const char *>(&dim0), sizeof(dim0));
+    ofs.write(reinterpret_cast<const char *>(&dim1), sizeof(dim1));
+    ofs.write(reinterpret_cast<const char *>(&dim2), sizeof(dim2));
+
+    // each chunk of rows has its own random generator, such that chunks can
+    // be generated in parallel and the result does not depend on threading.
+    // chunks hold at most 4096 rows or 4 MB, blocks (the rows held in
+    // memory) at most 64 MB in whole chunks, and no more rows than dim0.
+    const size_t       slice       = size_t(dim1) * dim2;
+    const size_t       row_bytes   = slice * sizeof(double);
+    const unsigned int chunk_rows  = std::max<size_t>(1, std::min<size_t>(4096, (size_t(4) << 20) / row_bytes));
+    const unsigned int block_rows  = std::max<size_t>(1, (size_t(64) << 20) / row_bytes / chunk_rows) * chunk_rows;
+    std::vector<double> block(std::min(dim0, block_rows) * slice);
+
+    for (unsigned int begin=0; begin<dim0; begin+=block_rows)
+    {
+        const unsigned int end      = std::min(dim0, begin + block_rows);
+        const unsigned int n_chunks = (end - begin + chunk_rows - 1) / chunk_rows;
+
+#pragma omp parallel for
+        for (int c=0; c<(int)n_chunks; ++c)
+        {
+            const unsigned int row0 = begin + c*chunk_rows;
+            const unsigned int row1 = std::min(end, row0 + chunk_rows);
+            std::mt19937 rng(seed ^ (row0 / chunk_rows + 1) * 2654435761u);
+            std::normal_distribution<double> normal(0.0, amplitude);
+            for (size_t i=size_t(row0-begin)*slice; i<size_t(row1-begin)*slice; ++i)
+                block[i] = normal(rng);
+        }
+
+        ofs.write(reinterpret_cast<const char *>(block.data()),
+                  size_t(end-begin) * slice * sizeof(double));
+    }
+    ofs.close();
+
+    return !ofs.fail();
+}
+
+//-----------------------------------------------------------------------------
+
+static void usage()
+{
+    std::cerr << "Usage: mlm_synth <output directory> [options]\n"
+              << "  -skin <n>       number of skin vertices (default 24574)\n"
+              << "  -skull <n>      number of skull vertices (default 69122)\n"
+              << "  -scale <s>      multiply both vertex counts by s\n"
+              << "  -dim1 <n>       number of skull parameters (default 7)\n"
+              << "  -dim2 <n>       number of FSTT parameters (default 4)\n"
+              << "  -subjects <n>   rows of the mode matrices U (default 50)\n"
+              << "  -amplitude <a>  standard deviation of tensor entries (default 1)\n"
+              << "  -seed <n>       random seed (default 0)\n";
+}
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    const std::string dir = std::string(argv[1]) + "/";
+    unsigned int n_skin     = 24574;
+    unsigned int n_skull    = 69122;
+    double       scale      = 1.0;
+    unsigned int dim1       = 7;
+    unsigned int dim2       = 4;
+    unsigned int n_subjects = 50;
+    double       amplitude  = 1.0;
+    unsigned int seed       = 0;
+
+    for (int i=2; i<argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (i+1 >= argc)
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+        if      (arg == "-skin")      n_skin     = std::atoi(argv[++i]);
+        else if (arg == "-skull")     n_skull    = std::atoi(argv[++i]);
+        else if (arg == "-scale")     scale      = std::atof(argv[++i]);
+        else if (arg == "-dim1")      dim1       = std::atoi(argv[++i]);
+        else if (arg == "-dim2")      dim2       = std::atoi(argv[++i]);
+        else if (arg == "-subjects")  n_subjects = std::atoi(argv[++i]);
+        else if (arg == "-amplitude") amplitude  = std::atof(argv[++i]);
+        else if (arg == "-seed")      seed       = std::atoi(argv[++i]);
+        else
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+    if (!dim1 || !dim2 || n_subjects < std::max(dim1, dim2))
+    {
+        std::cerr << "[ERROR] Need dim1, dim2 > 0 and at least max(dim1, dim2) subjects" << std::endl;
+        return EXIT_FAILURE;
+    }
+    n_skin  = std::lround(n_skin  * scale);
+    n_skull = std::lround(n_skull * scale);
+    if (!make_directory(argv[1]))
+        return EXIT_FAILURE;
+
+
+    // mean meshes: skull ellipsoid inside skin ellipsoid
+    pmp::SurfaceMesh skin, skull;
+    ellipsoid(skin,  n_skin,  75.0f, 95.0f, 115.0f);
+    ellipsoid(skull, n_skull, 68.0f, 88.0f, 105.0f);
+    if (!(skin.write(dir + "skin.off") && skull.write(dir + "skull.off")))
+    {
+        std::cerr << "Cannot write skin and skull meshes to " << dir << std::endl;
+        return EXIT_FAILURE;
+    }
+    const unsigned int dim0 = 3*(skin.n_vertices() + skull.n_vertices());
+
+
+    // mode matrices and eigenvalues
+    std::mt19937 rng(seed);
+    if (!save_matrix(random_mode_matrix(n_subjects, dim1, rng), dir + "matrix_U_skull.matrix") ||
+        !save_matrix(random_mode_matrix(n_subjects, dim2, rng), dir + "matrix_U_fstt.matrix") ||
+        !save_vector(random_eigenvalues(dim1, rng), dir + "eigenvalues_skull.vector") ||
+        !save_vector(random_eigenvalues(dim2, rng), dir + "eigenvalues_fstt.vector"))
+    {
+        return EXIT_FAILURE;
+    }
+
+
+    // tensor
+    if (!write_tensor(dir + "mlm_tensor.tensor", dim0, dim1, dim2, amplitude, seed))
+    {
+        return EXIT_FAILURE;
+    }
+
+
+    std::cout << "Wrote model to " << dir << ": "
+              << skin.n_vertices() << " skin vertices, "
+              << skull.n_vertices() << " skull vertices, "
+              << "tensor " << dim0 << " x " << dim1 << " x " << dim2
+              << " (" << double(dim0) * dim1 * dim2 * sizeof(double) / (1024.0*1024.0) << " MB)"
+              << std::endl;
+
+    return EXIT_SUCCESS;
+}
+
+//=============================================================================
@@ -16,6 +16,14 @@
 #include <Eigen/Dense>
 #include <string>
 #include <fstream>
+#include <cerrno>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include "PointCloudIO.h"
 
 
 //== HELPER ===================================================================
@@ -64,11 +72,53 @@ static bool load_vector(Eigen::VectorXd& eigenVector,
 
 //-----------------------------------------------------------------------------
 
+//! write matrix to binary file (format of load_matrix())
+static bool save_matrix(const Eigen::MatrixXd& eigenMatrix,
+                        const std::string& filename)
+{
+    std::ofstream ofs( filename.c_str(), std::ofstream::binary );
+    if (!ofs.is_open())
+    {
+        std::cerr << "Cannot write matrix " << filename << std::endl;
+        return false;
+    }
+    const unsigned int n_rows = eigenMatrix.rows();
+    const unsigned int n_cols = eigenMatrix.cols();
+    ofs.write(reinterpret_cast<const char *>(&n_rows), sizeof(n_rows));
+    ofs.write(reinterpret_cast<const char *>(&n_cols), sizeof(n_cols));
+    ofs.write(reinterpret_cast<const char *>(eigenMatrix.data()), n_rows*n_cols*sizeof(typename Eigen::MatrixXd::Scalar) );
+    ofs.close();
+
+    return !ofs.fail();
+}
+
+//-----------------------------------------------------------------------------
+
+//! write vector to binary file (format of load_vector())
+static bool save_vector(const Eigen::VectorXd& eigenVector,
+                        const std::string& filename)
+{
+    std::ofstream ofs( filename.c_str(), std::ofstream::binary );
+    if (!ofs.is_open())
+    {
+        std::cerr << "Cannot write vector " << filename << std::endl;
+        return false;
+    }
+    const unsigned int rows = eigenVector.size();
+    ofs.write(reinterpret_cast<const char *>(&rows), sizeof(rows));
+    ofs.write(reinterpret_cast<const char *>(eigenVector.data()), rows*sizeof(typename Eigen::VectorXd::Scalar) );
+    ofs.close();
+
+    return !ofs.fail();
+}
+
+//-----------------------------------------------------------------------------
+
 //! read vector with scalars from text file
 static bool load_scalars(std::vector<double>& output, const std::string& filename)
 {
-    std::ifstream ifs(filename);
-    if(!ifs.is_open())
+    std::vector<char> text;
+    if (!read_file(filename, text))
     {
         std::cerr << "Cannot read weights from " << filename << std::endl;
         return false;
@@ -76,16 +126,12 @@ static bool load_scalars(std::vector<double>& output, const std::string& filenam
 
     output.clear();
 
-    double val;
-    while (true)
+    if (!parse_numbers(text, output))
     {
-        ifs >> val;
-        if (ifs.eof()) break;
-        output.push_back(val);
+        std::cerr << "Cannot parse weights in " << filename << std::endl;
+        return false;
     }
 
-    ifs.close();
-
     return (!output.empty());
 }
 
@@ -136,4 +182,22 @@ static bool load_parameters(Eigen::VectorXd& wSkull,
     return true;
 }
 
+//-----------------------------------------------------------------------------
+
+//! create directory 'dirname' unless it exists (parent directories must exist)
+static bool make_directory(const std::string& dirname)
+{
+#ifdef _WIN32
+    const int result = _mkdir(dirname.c_str());
+#else
+    const int result = mkdir(dirname.c_str(), 0755);
+#endif
+    if (result != 0 && errno != EEXIST)
+    {
+        std::cerr << "[ERROR] in 'make_directory(...)' - Can't create " << dirname << std::endl;
+        return false;
+    }
+    return true;
+}
+
 //=============================================================================